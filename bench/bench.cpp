@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// bench.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Micro-benchmarks of the navigation and tracking math and the CAVEGet*
+// dispatch. No HMD is needed.
+//
+//   bench [--json <file>]
+//
+// prints ns/op and allocations/op, and writes the results as JSON for trend
+// tracking with --json.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "bench.h"
+#include "../src/clcl.h"
+
+std::atomic<long long> g_Allocations(0);
+volatile float g_Sink;
+
+// counts every allocation of the process, including those in CLCL
+void* operator new(size_t size)
+{
+	g_Allocations++;
+	void *ptr = malloc((size > 0) ? size : 1);
+	if (ptr == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	free(ptr);
+}
+
+std::vector<BenchResult>& BenchResults()
+{
+	static std::vector<BenchResult> results;
+	return results;
+}
+
+namespace
+{
+	bool WriteJSON(const char *path)
+	{
+		FILE *file = fopen(path, "w");
+		if (file == nullptr)
+		{
+			fprintf(stderr, "bench: cannot open %s\n", path);
+			return false;
+		}
+		const std::vector<BenchResult>& results = BenchResults();
+		fprintf(file, "{\n  \"benchmarks\": [\n");
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			fprintf(file, "    { \"name\": \"%s\", \"iterations\": %lld, \"ns_per_op\": %.3f, \"allocs_per_op\": %.3f }%s\n",
+				results[i].Name.c_str(), results[i].Iterations, results[i].NsPerOp, results[i].AllocsPerOp,
+				(i + 1 < results.size()) ? "," : "");
+		}
+		fprintf(file, "  ]\n}\n");
+		fclose(file);
+		return true;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *jsonPath = nullptr;
+	for (int i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "--json") == 0) && (i + 1 < argc))
+		{
+			jsonPath = argv[++i];
+		}
+	}
+
+	CAVEConfigure(&argc, argv, NULL); // CLCL without CAVEInit(): no HMD, no display thread
+
+	RunNavigationBenchmarks();
+	RunTrackingBenchmarks();
+
+	printf("%-36s %12s %12s\n", "", "ns/op", "allocs/op");
+	for (const BenchResult& result : BenchResults())
+	{
+		printf("%-36s %12.2f %12.3f\n", result.Name.c_str(), result.NsPerOp, result.AllocsPerOp);
+	}
+
+	if ((jsonPath != nullptr) && !WriteJSON(jsonPath))
+	{
+		return 1;
+	}
+	return 0;
+}
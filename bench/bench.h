@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// bench.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+const int NUM_ITERATIONS = 1000000;
+
+struct BenchResult
+{
+	std::string Name;
+	long long   Iterations;
+	double      NsPerOp;
+	double      AllocsPerOp;
+};
+
+// operator new calls of the whole process (bench.cpp)
+extern std::atomic<long long> g_Allocations;
+extern volatile float g_Sink;
+
+std::vector<BenchResult>& BenchResults();
+
+// runs function(i) for i = 0, ..., iterations - 1 after a short warm-up
+template <typename FUNCTION>
+void Measure(const char *name, FUNCTION function, int iterations = NUM_ITERATIONS)
+{
+	for (int i = 0; i < iterations / 100; i++)
+	{
+		function(i);
+	}
+
+	long long allocations = g_Allocations.load();
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		function(i);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+
+	BenchResult result;
+	result.Name = name;
+	result.Iterations = iterations;
+	result.NsPerOp = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+	result.AllocsPerOp = static_cast<double>(g_Allocations.load() - allocations) / iterations;
+	BenchResults().push_back(result);
+}
+
+void RunNavigationBenchmarks();
+void RunTrackingBenchmarks();
@@ -0,0 +1,223 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// bench_navigation.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+#include <cmath>
+
+#include "../src/hmd/oculus/oculus.h"
+
+namespace
+{
+	// general 4x4 math as used before the affine navigation transform
+	struct Matrix4
+	{
+		float M[4][4];
+
+		static Matrix4 Identity()
+		{
+			Matrix4 m;
+			for (int i = 0; i < 4; i++)
+			{
+				for (int j = 0; j < 4; j++)
+				{
+					m.M[i][j] = (i == j) ? 1.0f : 0.0f;
+				}
+			}
+			return m;
+		}
+
+		static Matrix4 Translation(float x, float y, float z)
+		{
+			Matrix4 m = Identity();
+			m.M[0][3] = x;
+			m.M[1][3] = y;
+			m.M[2][3] = z;
+			return m;
+		}
+
+		static Matrix4 RotationY(float angle)
+		{
+			Matrix4 m = Identity();
+			m.M[0][0] =  cosf(angle);
+			m.M[0][2] =  sinf(angle);
+			m.M[2][0] = -sinf(angle);
+			m.M[2][2] =  cosf(angle);
+			return m;
+		}
+
+		Matrix4 operator*(const Matrix4& b) const
+		{
+			Matrix4 c;
+			for (int i = 0; i < 4; i++)
+			{
+				for (int j = 0; j < 4; j++)
+				{
+					c.M[i][j] = M[i][0] * b.M[0][j] + M[i][1] * b.M[1][j] + M[i][2] * b.M[2][j] + M[i][3] * b.M[3][j];
+				}
+			}
+			return c;
+		}
+
+		float Cofactor(int row, int column) const
+		{
+			float m[3][3];
+			for (int i = 0, r = 0; i < 4; i++)
+			{
+				if (i == row)
+				{
+					continue;
+				}
+				for (int j = 0, c = 0; j < 4; j++)
+				{
+					if (j != column)
+					{
+						m[r][c++] = M[i][j];
+					}
+				}
+				r++;
+			}
+			float minor =
+				m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+				m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+				m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+			return ((row + column) & 1) ? -minor : minor;
+		}
+
+		Matrix4 Inverted() const
+		{
+			Matrix4 adjugate;
+			for (int i = 0; i < 4; i++)
+			{
+				for (int j = 0; j < 4; j++)
+				{
+					adjugate.M[j][i] = Cofactor(i, j);
+				}
+			}
+			float det = M[0][0] * adjugate.M[0][0] + M[0][1] * adjugate.M[1][0] + M[0][2] * adjugate.M[2][0] + M[0][3] * adjugate.M[3][0];
+			for (int i = 0; i < 4; i++)
+			{
+				for (int j = 0; j < 4; j++)
+				{
+					adjugate.M[i][j] /= det;
+				}
+			}
+			return adjugate;
+		}
+	};
+
+}
+
+void RunNavigationBenchmarks()
+{
+	// CAVENavTranslate / CAVENavRot: Matrix4f as before the affine navigation transform
+	{
+		Matrix4 matrix = Matrix4::Identity();
+		Measure("nav update/matrix4", [&](int i) {
+			if (i & 1)
+			{
+				matrix = Matrix4::Translation(-0.01f, 0.0f, -0.02f) * matrix;
+			}
+			else
+			{
+				matrix = Matrix4::RotationY(-0.001f) * matrix;
+			}
+		});
+		g_Sink = matrix.M[0][3];
+
+		NavigationTransform navigation;
+		Measure("nav update/affine", [&](int i) {
+			if (i & 1)
+			{
+				navigation.PreTranslate(-0.01f, 0.0f, -0.02f);
+			}
+			else
+			{
+				navigation.PreRotate(-0.001f, 'y');
+			}
+		});
+		g_Sink = static_cast<float>(navigation.transform().Translation[0]);
+	}
+
+	// one navigation update per frame, then the inverses for the head, both
+	// hands and CAVENavInverseTransform()
+	{
+		Matrix4 matrix = Matrix4::RotationY(0.3f) * Matrix4::Translation(1.0f, 2.0f, 3.0f);
+		Measure("frame inverses/matrix4", [&](int i) {
+			matrix = Matrix4::Translation(-0.01f, 0.0f, 0.0f) * matrix;
+			float sum = 0.0f;
+			for (int n = 0; n < 4; n++)
+			{
+				sum += matrix.Inverted().M[0][3];
+			}
+			g_Sink = sum;
+		});
+
+		NavigationTransform navigation;
+		navigation.PreTranslate(1.0f, 2.0f, 3.0f);
+		navigation.PreRotate(0.3f, 'y');
+		Measure("frame inverses/affine", [&](int i) {
+			navigation.PreTranslate(-0.01f, 0.0f, 0.0f);
+			double sum = 0.0;
+			for (int n = 0; n < 4; n++)
+			{
+				sum += navigation.inverse().Translation[0];
+			}
+			g_Sink = static_cast<float>(sum);
+		});
+	}
+
+	// inverses without navigation changes (the common case)
+	{
+		Matrix4 matrix = Matrix4::RotationY(0.3f) * Matrix4::Translation(1.0f, 2.0f, 3.0f);
+		Measure("inverse unchanged/matrix4", [&](int i) {
+			g_Sink = matrix.Inverted().M[0][3];
+		});
+
+		NavigationTransform navigation;
+		navigation.PreTranslate(1.0f, 2.0f, 3.0f);
+		navigation.PreRotate(0.3f, 'y');
+		Measure("inverse unchanged/affine", [&](int i) {
+			g_Sink = static_cast<float>(navigation.inverse().Translation[0]);
+		});
+	}
+
+	// the navigation functions of Oculus as called by the CAVENav* API
+	{
+		Oculus *oculus = new Oculus(); // no session: only the navigation state is used
+		float matrix[4][4] = {
+			{ 1.0f, 0.0f, 0.0f, 0.0f },
+			{ 0.0f, 1.0f, 0.0f, 0.0f },
+			{ 0.0f, 0.0f, 1.0f, 0.0f },
+			{ 0.01f, 0.0f, -0.01f, 1.0f } };
+
+		Measure("Oculus::Translate", [&](int i) { oculus->Translate(0.01f, 0.0f, -0.01f); });
+		Measure("Oculus::Rotate", [&](int i) { oculus->Rotate(0.1f, 'y'); });
+		Measure("Oculus::Scale", [&](int i) {
+			float scale = (i & 1) ? 1.001f : 1.0f / 1.001f;
+			oculus->Scale(scale, scale, scale);
+		});
+		Measure("Oculus::WorldTranslate", [&](int i) { oculus->WorldTranslate(0.01f, 0.0f, -0.01f); });
+		Measure("Oculus::WorldRotate", [&](int i) { oculus->WorldRotate(0.1f, 'y'); });
+		Measure("Oculus::WorldScale", [&](int i) {
+			float scale = (i & 1) ? 1.001f : 1.0f / 1.001f;
+			oculus->WorldScale(scale, scale, scale);
+		});
+		Measure("Oculus::MultiNavigationMatrix", [&](int i) { oculus->MultiNavigationMatrix(matrix); });
+		Measure("Oculus::PreMultiNavigationMatrix", [&](int i) { oculus->PreMultiNavigationMatrix(matrix); });
+		double navigationMatrix[4][4];
+		oculus->GetNavigationMatrix(navigationMatrix);
+		g_Sink = static_cast<float>(navigationMatrix[0][3]);
+		delete oculus;
+	}
+}
@@ -0,0 +1,160 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// bench_tracking.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "../src/hmd/oculus/oculus.h"
+#include "../src/clcl.h"
+
+namespace
+{
+	// a head turning and walking around with both hands in front of it,
+	// 90 samples per second
+	void SyntheticTrackingState(int sample, ovrTrackingState& trackingState)
+	{
+		memset(&trackingState, 0, sizeof(trackingState));
+		float angle = 0.01f * sample;
+		trackingState.StatusFlags = ovrStatus_OrientationTracked | ovrStatus_PositionTracked;
+		trackingState.HeadPose.TimeInSeconds = sample / 90.0;
+		trackingState.HeadPose.ThePose.Orientation.x = 0.0f;
+		trackingState.HeadPose.ThePose.Orientation.y = sinf(0.5f * angle);
+		trackingState.HeadPose.ThePose.Orientation.z = 0.0f;
+		trackingState.HeadPose.ThePose.Orientation.w = cosf(0.5f * angle);
+		trackingState.HeadPose.ThePose.Position.x = 0.5f * cosf(angle);
+		trackingState.HeadPose.ThePose.Position.y = 1.6f;
+		trackingState.HeadPose.ThePose.Position.z = 0.5f * sinf(angle);
+#if (OVR_PRODUCT_VERSION == 1)
+		for (int i = 0; i < ovrHand_Count; i++)
+		{
+			trackingState.HandStatusFlags[i] = trackingState.StatusFlags;
+			trackingState.HandPoses[i].ThePose = trackingState.HeadPose.ThePose;
+			trackingState.HandPoses[i].ThePose.Position.x += (i == ovrHand_Left) ? -0.2f : 0.2f;
+			trackingState.HandPoses[i].ThePose.Position.y -= 0.4f;
+		}
+#endif
+	}
+
+	// the same motion as a frame of the pose history
+	void SyntheticPoseFrame(int sample, PoseFrame& frame)
+	{
+		memset(&frame, 0, sizeof(frame));
+		float angle = 0.01f * sample;
+		frame.Time = sample / 90.0;
+		frame.TrackedDevices = (1u << POSE_HEAD);
+		for (int space = 0; space < 2; space++)
+		{
+			Pose& pose = frame.Device[POSE_HEAD][space];
+			pose.Position[0] = 0.5f * cosf(angle);
+			pose.Position[1] = 1.6f;
+			pose.Position[2] = 0.5f * sinf(angle);
+			pose.Orientation[1] = sinf(0.5f * angle);
+			pose.Orientation[3] = cosf(0.5f * angle);
+		}
+	}
+}
+
+void RunTrackingBenchmarks()
+{
+	// the per-device transforms of UpdateTrackingData() (head, eyes and
+	// hands) on synthetic states, without the runtime calls around them
+	{
+		Oculus *oculus = new Oculus(); // no session
+		oculus->Translate(1.0f, 0.0f, -2.0f);
+		oculus->Rotate(30.0f, 'y');
+
+		const int numStates = 256;
+		std::vector<ovrTrackingState> trackingStates(numStates);
+		for (int i = 0; i < numStates; i++)
+		{
+			SyntheticTrackingState(i, trackingStates[i]);
+		}
+		Measure("UpdateTrackingData transforms", [&](int i) {
+			oculus->StoreTrackingState(trackingStates[i & (numStates - 1)], true);
+		});
+		g_Sink = oculus->headTranslationNav().x;
+		delete oculus;
+	}
+
+	// sampling of a filled pose history
+	{
+		PoseHistory *history = new PoseHistory();
+		PoseFrame frame;
+		for (int i = 0; i < POSE_HISTORY_SIZE; i++)
+		{
+			SyntheticPoseFrame(i, frame);
+			history->Publish(frame);
+		}
+
+		Pose pose;
+		double latest = frame.Time;
+		if (!history->Sample(latest - 0.1, POSE_HEAD, true, pose) ||
+			!history->Extrapolate(latest + 0.01, POSE_HEAD, true, pose))
+		{
+			fprintf(stderr, "bench: the pose history has no samples, PoseHistory::* skipped\n");
+		}
+		else
+		{
+			Measure("PoseHistory::Sample", [&](int i) {
+				history->Sample(latest - 0.001 * (i & 255), POSE_HEAD, true, pose);
+				g_Sink = pose.Position[0];
+			});
+			Measure("PoseHistory::Extrapolate", [&](int i) {
+				history->Extrapolate(latest + 0.0001 * (i & 255), POSE_HEAD, true, pose);
+				g_Sink = pose.Position[0];
+			});
+		}
+		delete history;
+	}
+
+	// the CAVEGet* dispatch of a typical frame (CAVEConfigure() without CAVEInit())
+	{
+		float position[3], vector[3], angle[3];
+		Measure("CAVEGetPosition", [&](int i) {
+			CAVEGetPosition((i & 1) ? CAVE_WAND_NAV : CAVE_HEAD, position);
+			g_Sink = position[0];
+		});
+		Measure("CAVEGetVector", [&](int i) {
+			CAVEGetVector((i & 1) ? CAVE_WAND_FRONT_NAV : CAVE_HEAD_UP, vector);
+			g_Sink = vector[0];
+		});
+		Measure("CAVEGetOrientation", [&](int i) {
+			CAVEGetOrientation((i & 1) ? CAVE_WAND_NAV : CAVE_HEAD, angle);
+			g_Sink = angle[0];
+		});
+
+		// head and wand positions, front/up vectors and orientations
+		Measure("CAVEGet* x12", [&](int i) {
+			static const CAVEID positionIDs[4] = { CAVE_HEAD, CAVE_WAND, CAVE_HEAD_NAV, CAVE_WAND_NAV };
+			static const CAVEID vectorIDs[4] = { CAVE_HEAD_FRONT, CAVE_HEAD_UP, CAVE_WAND_FRONT_NAV, CAVE_WAND_UP_NAV };
+			float sum = 0.0f;
+			for (int n = 0; n < 4; n++)
+			{
+				CAVEGetPosition(positionIDs[n], position);
+				CAVEGetVector(vectorIDs[n], vector);
+				CAVEGetOrientation(positionIDs[n], angle);
+				sum += position[0] + vector[0] + angle[0];
+			}
+			g_Sink = sum;
+		}, NUM_ITERATIONS / 10);
+
+		CAVESENSORSNAPSHOT snapshot;
+		Measure("CAVEGetSensorSnapshot", [&](int i) {
+			CAVEGetSensorSnapshot(&snapshot);
+			g_Sink = snapshot.sensorNav[CAVE_SENSOR_RIGHT_HAND].front[0];
+		}, NUM_ITERATIONS / 10);
+	}
+}
@@ -26,6 +26,7 @@
 #define _USE_MATH_DEFINES
 #include <iostream>
 #include <cmath>
+#include <functional>
 
 extern float CAVENear, CAVEFar;
 //float CAVENearTLS[4], CAVEFarTLS[4];
@@ -105,7 +106,12 @@ typedef enum {
 	CAVE_SIM_DRAWUSER,
 	CAVE_SIM_DRAWWAND,
 	CAVE_SIM_VIEWMODE,
-	CAVE_TRACKER_SIGNALRESET
+	CAVE_TRACKER_SIGNALRESET,
+
+	// CLCL extensions
+	CAVE_SHMEM_LARGEPAGES,
+	CAVE_FRAMEALLOC_SIZE,
+	CAVE_ASYNC_INIT
 
 } CAVEID;
 
@@ -251,6 +257,14 @@ void  CAVEInit();
 void  CAVEExit();
 void  CAVEHalt();
 
+// CAVEInit() returns once the HMD session, the window and the GL context are
+// up, and exits the process if the startup fails. After
+// CAVESetOption(CAVE_ASYNC_INIT, 1) it returns at once, and the app can load
+// its data during the startup; the keys and buttons read as released until
+// CAVEWaitForInit() returns true, which also sets CAVESync->Initted. It
+// returns false if the startup failed.
+bool  CAVEWaitForInit();
+
 typedef void (* CAVECALLBACK)();
 
 void  CAVEInitApplication(CAVECALLBACK callback, int num_arg, ...);
@@ -258,9 +272,365 @@ void  CAVEDisplay(CAVECALLBACK callback, int num_arg, ...);
 void  CAVEFrameFunction(CAVECALLBACK callback, int num_arg, ...);
 void  CAVEStopApplication(CAVECALLBACK callback, int arg_num, ...);
 
+// the callbacks above also take lambdas and std::function
+typedef std::function<void()> CAVEFUNCTION;
+void  CAVEInitApplication(CAVEFUNCTION callback);
+void  CAVEDisplay(CAVEFUNCTION callback);
+void  CAVEFrameFunction(CAVEFUNCTION callback);
+void  CAVEStopApplication(CAVEFUNCTION callback);
+
+// quad layers composited by the runtime (Oculus SDK 1.x only)
+// The content is redrawn by the callback only after CAVEUpdateQuadLayer()
+// is called; it is drawn in normalized device coordinates.
+typedef int CAVELAYER;
+CAVELAYER CAVENewQuadLayer(int width, int height, bool headLocked);
+void  CAVEFreeQuadLayer(CAVELAYER layer);
+void  CAVEQuadLayerFunction(CAVELAYER layer, CAVECALLBACK callback, int num_arg, ...);
+void  CAVEQuadLayerFunction(CAVELAYER layer, CAVEFUNCTION callback);
+void  CAVESetQuadLayerPose(CAVELAYER layer, float position[3], float angle[3], float size[2]);
+void  CAVEUpdateQuadLayer(CAVELAYER layer);
+
+// background uploads on a GL context shared with the display thread
+// The callback runs on the loader thread; only textures, buffers, shaders and
+// programs are shared. Poll CAVEUploadDone() before using the objects.
+typedef int CAVEUPLOAD;
+CAVEUPLOAD CAVEUploadData(CAVECALLBACK callback, int num_arg, ...);
+CAVEUPLOAD CAVEUploadData(CAVEFUNCTION callback);
+bool  CAVEUploadDone(CAVEUPLOAD upload);
+void  CAVEUploadWait(CAVEUPLOAD upload);
+
+// GLSL programs built through the program-binary cache
+// (must be called from a thread with a GL context, e.g. in the init callback)
+GLuint CAVECreateProgram(const char *vertexShader, const char *fragmentShader);
+void  CAVEGetProgramCacheStats(int *hits, int *misses, float *savedSeconds);
+
+// view frustum of the current frame, planes (a, b, c, d) in the order
+// left, right, bottom, top, near, far; ax + by + cz + d >= 0 is inside.
+// CAVE_HEAD(_NAV) gives the frustum enclosing both eyes, CAVE_LEFT_EYE(_NAV) and
+// CAVE_RIGHT_EYE(_NAV) those of each eye, in CAVE (or navigated) coordinates.
+void  CAVEGetFrustum(CAVEID id, float planes[6][4]);
+// batch culling: spheres are (x, y, z, radius), boxes are (min x, y, z, max x, y, z);
+// visible[i] is set to 0 or 1 and the number of visible objects is returned
+int   CAVECullSpheres(float planes[6][4], const float *spheres, int count, unsigned char *visible, bool parallel);
+int   CAVECullBoxes(float planes[6][4], const float *boxes, int count, unsigned char *visible, bool parallel);
+
+// screen-space-error LOD selection
+// errors are the geometric errors of the levels (finest first) in CAVE or
+// navigated units. Levels are selected once per frame after the frame function
+// against the eye projections; CAVEGetLODLevels() fills levels[object]
+// (-1: outside the view frustum) and returns the number of object IDs.
+// triangleBudget <= 0 disables the budget.
+typedef int CAVELOD;
+CAVELOD CAVENewLODObject(float center[3], float radius, int numLevels, const float *errors, const int *triangles, bool navigated);
+void  CAVEFreeLODObject(CAVELOD object);
+void  CAVESetLODBounds(CAVELOD object, float center[3], float radius);
+void  CAVESetLODOptions(float pixelError, float hysteresis, long long triangleBudget);
+int   CAVEGetLODLevels(int *levels, int maxCount);
+
+// pose history of the tracked devices (the latest 1024 tracking samples)
+// Times are in seconds on the clock of CAVEGetTrackingTime(); poses between
+// samples are interpolated and velocities are in units (radians) per second.
+typedef enum {
+	CAVE_TRACKED_HEAD = 0,
+	CAVE_TRACKED_LEFT_HAND,
+	CAVE_TRACKED_RIGHT_HAND
+} CAVETRACKEDDEVICE;
+
+typedef struct {
+	double time;
+	float  position[3];    // CAVE (or navigated) coordinate
+	float  orientation[4]; // quaternion (x, y, z, w)
+} CAVEPOSE;
+
+double CAVEGetTrackingTime();
+bool  CAVEGetPoseAtTime(CAVETRACKEDDEVICE device, bool navigated, double time, CAVEPOSE *pose);
+bool  CAVEGetPoseVelocity(CAVETRACKEDDEVICE device, bool navigated, double time, float linear[3], float angular[3]);
+int   CAVEGetPoseHistory(CAVETRACKEDDEVICE device, bool navigated, double fromTime, CAVEPOSE *poses, int maxCount);
+
+// every tracked sensor of the latest display frame in one consistent snapshot
+typedef enum {
+	CAVE_SENSOR_HEAD = 0,
+	CAVE_SENSOR_LEFT_EYE,
+	CAVE_SENSOR_RIGHT_EYE,
+	CAVE_SENSOR_LEFT_HAND,
+	CAVE_SENSOR_RIGHT_HAND,
+	CAVE_SENSOR_COUNT
+} CAVESENSORID;
+
+typedef struct {
+	float position[3];
+	float orientation[4]; // quaternion (x, y, z, w)
+	float angle[3];       // Euler angles as CAVEGetOrientation()
+	float front[3];       // unit vectors
+	float up[3];
+	float right[3];
+} CAVESENSORSTATE;
+
+typedef struct {
+	long long       frame;
+	double          time;    // clock of CAVEGetTrackingTime()
+	unsigned int    tracked; // bit (1 << CAVESENSORID)
+	CAVESENSORSTATE sensor[CAVE_SENSOR_COUNT];    // CAVE coordinate
+	CAVESENSORSTATE sensorNav[CAVE_SENSOR_COUNT]; // navigated coordinate
+} CAVESENSORSNAPSHOT;
+
+void  CAVEGetSensorSnapshot(CAVESENSORSNAPSHOT *snapshot);
+
+// poses predicted for a display time, for app-side work that has to line up
+// with the frame it appears in (e.g. time = CAVEGetPredictedDisplayTime(1)).
+// The runtime prediction is used while the device is tracked, otherwise the
+// pose history is extrapolated; vectors are unit length.
+double CAVEGetPredictedDisplayTime(int framesAhead);
+void  CAVEGetPredictedPosition(CAVEID id, double time, float position[3]);
+void  CAVEGetPredictedVector(CAVEID id, double time, float vector[3]);
+
+// optional tracker thread (CAVE_TRACKER_PROCESS) sampling the tracked devices
+// into the pose history at rate Hz (up to 1000) between frames; 0 stops it
+void  CAVESetTrackerRate(int rate);
+
+// latency of the display pipeline: a per-frame trace and histograms
+// Times are in seconds on the clock of CAVEGetTrackingTime() (0 while unknown);
+// the display time comes from the runtime's performance stats (SDK 1.x) a few
+// frames after the submission. CAVEPublishAppData() stamps a new version of
+// the app data, whose age at submission is measured for the frames drawing it.
+typedef enum {
+	CAVE_LATENCY_SAMPLE_TO_SUBMIT = 0,
+	CAVE_LATENCY_MOTION_TO_PHOTON,
+	CAVE_LATENCY_PREDICTION_ERROR, // displayed - predicted display time
+	CAVE_LATENCY_APP_DATA_AGE
+} CAVELATENCY;
+
+const int CAVE_LATENCY_BINS = 100;
+
+typedef struct {
+	long long frame;
+	double    sampleTime;
+	double    predictedDisplayTime;
+	double    submitTime;
+	double    displayTime;
+	long long appDataVersion;
+	double    appDataTime;
+} CAVELATENCYFRAME;
+
+long long CAVEPublishAppData();
+int   CAVEGetLatencyTrace(CAVELATENCYFRAME *frames, int maxCount);
+int   CAVEGetLatencyHistogram(CAVELATENCY metric, int counts[CAVE_LATENCY_BINS], float *minMs, float *maxMs);
+void  CAVEResetLatencyStats();
+
+// fixed-timestep simulation
+// callback is called rate times per second on a simulation thread that runs
+// ahead of the display by its latency; CAVEGetSimulationTime() is the time
+// (clock of CAVEGetTrackingTime()) the running step advances the state to.
+// Registered arrays are copied from source[] after each step and interpolated
+// into display[] for the display time before the draw callback of each frame;
+// CAVEGetSimulationAlpha() is the factor (0: previous step, 1: latest step)
+// for the state interpolated by the draw callback itself.
+void  CAVESimulationFunction(float rate, CAVECALLBACK callback, int num_arg, ...);
+void  CAVESimulationFunction(float rate, CAVEFUNCTION callback);
+void  CAVEStopSimulation();
+double CAVEGetSimulationTime();
+float CAVEGetSimulationAlpha();
+int   CAVERegisterSimulationArray(float *source, float *display, int count);
+void  CAVEUnregisterSimulationArray(int arrayID);
+
+// CAVEMalloc() memory is 64-byte aligned and comes from one arena of
+// CAVE_SHMEM_SIZE bytes, created at the first call. CAVE_SHMEM_ADDRESS is a
+// base address hint in units of 64 KB and CAVE_SHMEM_LARGEPAGES requests large
+// pages; both must be set before the first CAVEMalloc().
 void* CAVEMalloc(size_t size);
 void  CAVEFree(void* ptr);
 
+// Shared CAVEMalloc() arena: the first process creates a named mapping of
+// CAVE_SHMEM_SIZE bytes at CAVE_SHMEM_ADDRESS and later processes calling
+// CAVESetSharedArena() with the same name attach it at the same address, so
+// CAVEMalloc() pointers are valid in all of them. Call it before the first
+// CAVEMalloc(); the shared root is a pointer for the other processes to find.
+// It returns false, and CAVEMalloc() uses a private arena, if the mapping
+// cannot be created or CAVE_SHMEM_ADDRESS is set but not available. When the
+// shared arena is exhausted CAVEMalloc() returns NULL; only a private arena
+// falls back to malloc().
+bool  CAVESetSharedArena(const char *name);
+void  CAVESetSharedRoot(void *ptr);
+void* CAVEGetSharedRoot();
+
+// per-thread scratch memory released at frame boundaries
+// Memory allocated in one frame stays valid until the end of the next frame;
+// it must not be freed. CAVE_FRAMEALLOC_SIZE sets the initial buffer size and
+// the high-water mark (the largest frame of any thread) helps to size it.
+void* CAVEFrameAlloc(size_t size, size_t align);
+void  CAVEGetFrameAllocStats(size_t *used, size_t *highWater);
+
+// memory counters per category; GPU categories are estimates for the objects
+// CLCL creates. CAVESetMemoryLogInterval() prints all of them periodically.
+typedef enum {
+	CAVE_MEMORY_CAVEMALLOC = 0,
+	CAVE_MEMORY_FRAME_ALLOC,
+	CAVE_MEMORY_HOST_BUFFER,
+	CAVE_MEMORY_GPU_RENDER_TARGET,
+	CAVE_MEMORY_GPU_QUAD_LAYER,
+	CAVE_MEMORY_GPU_CAMERA,
+	CAVE_MEMORY_CATEGORY_COUNT
+} CAVEMEMORY;
+
+typedef struct {
+	long long liveBytes;
+	long long peakBytes;
+	long long allocations;
+	long long frees;
+	float     allocationsPerFrame;
+	float     bytesPerFrame;
+} CAVEMEMORYSTATS;
+
+void  CAVEGetMemoryStats(CAVEMEMORY category, CAVEMEMORYSTATS *stats);
+void  CAVESetMemoryLogInterval(float seconds); // 0: off
+
+// worker pool for compute callbacks, one worker per logical processor except
+// the one reserved for the display thread; the calling thread takes part.
+// "grain" is the number of indices per chunk.
+void  CAVEParallelFor(int begin, int end, int grain, std::function<void(int)> function);
+void  CAVEParallelForRange(int begin, int end, int grain, std::function<void(int, int)> function);
+int   CAVENumWorkerThreads();
+
+// fork/join: tasks spawned into a group run on the workers until joined
+typedef void *CAVETASKGROUP;
+CAVETASKGROUP CAVENewTaskGroup();
+void  CAVESpawnTask(CAVETASKGROUP group, CAVEFUNCTION task);
+void  CAVEJoinTaskGroup(CAVETASKGROUP group);
+void  CAVEFreeTaskGroup(CAVETASKGROUP group);
+
+// frame jobs: a job runs on the workers after its dependencies, while the
+// current frame is rendered, and every job submitted during a frame is done
+// before the next frame's idle and draw callbacks. 0 is "no job", and
+// "dependencies" may be NULL when "numDependencies" is 0.
+typedef long long CAVEJOB;
+CAVEJOB CAVESubmitJob(CAVEFUNCTION job, const CAVEJOB *dependencies, int numDependencies);
+bool  CAVEJobDone(CAVEJOB job);
+void  CAVEWaitJob(CAVEJOB job); // runs other jobs meanwhile
+
+// frame tasks: long jobs done a slice per frame by the display thread, after
+// the frame function, in the time the frame leaves (at most the budget set by
+// CAVESetFrameTaskBudget(), 4 ms by default). step is called again and again,
+// also several times per frame, until it returns false; it splits its work by
+// CAVEFrameTimeLeft() and calls CAVEWaitNextFrame() to be called again only in
+// the next frame. Steps run with the GL context current, and as the draw
+// function runs on the same thread they need no locks against it.
+typedef int CAVEFRAMETASK;
+CAVEFRAMETASK CAVEStartFrameTask(std::function<bool()> step);
+void  CAVECancelFrameTask(CAVEFRAMETASK task);
+bool  CAVEFrameTaskRunning(CAVEFRAMETASK task);
+void  CAVESetFrameTaskBudget(float milliseconds);
+double CAVEFrameTimeLeft(); // seconds, in a step
+void  CAVEWaitNextFrame();  // in a step
+
+// with C++20 coroutines a frame task can be written as a coroutine:
+//   CAVETASK Reseed()
+//   {
+//       for (int i = 0; i < numLines; i++)
+//       {
+//           co_await CAVEBudget(0.05f); // next frame if less than 0.05 ms left
+//           SeedLine(i);
+//       }
+//       co_await CAVENextFrame();
+//       ...
+//   }
+//   CAVEStartFrameTask(Reseed());
+#if defined(__cpp_impl_coroutine) && (__cpp_impl_coroutine >= 201902L)
+#include <coroutine>
+#include <exception>
+#include <memory>
+
+struct CAVETASK
+{
+	struct promise_type
+	{
+		CAVETASK get_return_object() { return CAVETASK(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+
+	explicit CAVETASK(std::coroutine_handle<promise_type> handle) : Handle(handle) {}
+	CAVETASK(CAVETASK&& other) noexcept : Handle(other.Handle) { other.Handle = nullptr; }
+	CAVETASK(const CAVETASK&) = delete;
+	CAVETASK& operator=(const CAVETASK&) = delete;
+	~CAVETASK() { if (Handle) Handle.destroy(); }
+
+	std::coroutine_handle<promise_type> Handle;
+};
+
+// resumed in the next frame
+struct CAVENEXTFRAME
+{
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<>) const { CAVEWaitNextFrame(); }
+	void await_resume() const noexcept {}
+};
+
+// goes on if the frame has "milliseconds" left, else resumed in the next frame
+struct CAVEBUDGET
+{
+	float milliseconds;
+	bool await_ready() const { return CAVEFrameTimeLeft() * 1000.0 >= milliseconds; }
+	void await_suspend(std::coroutine_handle<>) const { CAVEWaitNextFrame(); }
+	void await_resume() const noexcept {}
+};
+
+inline CAVENEXTFRAME CAVENextFrame() { return CAVENEXTFRAME(); }
+inline CAVEBUDGET CAVEBudget(float milliseconds) { return CAVEBUDGET{ milliseconds }; }
+
+inline CAVEFRAMETASK CAVEStartFrameTask(CAVETASK task)
+{
+	// the coroutine is destroyed with the step, also when it is cancelled
+	std::shared_ptr<CAVETASK> coroutine = std::make_shared<CAVETASK>(std::move(task));
+	return CAVEStartFrameTask(std::function<bool()>([coroutine]()
+	{
+		coroutine->Handle.resume();
+		return !coroutine->Handle.done();
+	}));
+}
+#endif
+
+// thread scheduling per CLCL thread: affinity (a mask of logical processors,
+// 0: those not isolated for other threads), isolation (the other threads keep
+// off the mask) and priority. They can be changed at any time; each thread
+// applies them in its loop. CAVE_PRIORITY_REALTIME is SCHED_FIFO on Linux and
+// time critical in a high priority process on Windows.
+typedef enum {
+	CAVE_THREAD_DISPLAY = 0,
+	CAVE_THREAD_TRACKER,
+	CAVE_THREAD_CAMERA,
+	CAVE_THREAD_WORKER,
+	CAVE_THREAD_SIMULATION,
+	CAVE_THREAD_LOADER,
+	CAVE_THREAD_COUNT
+} CAVETHREAD;
+
+typedef enum {
+	CAVE_PRIORITY_DEFAULT = 0,
+	CAVE_PRIORITY_LOW,
+	CAVE_PRIORITY_NORMAL,
+	CAVE_PRIORITY_HIGH,
+	CAVE_PRIORITY_HIGHEST,
+	CAVE_PRIORITY_REALTIME
+} CAVEPRIORITY;
+
+void  CAVESetThreadAffinity(CAVETHREAD thread, unsigned long long mask, bool isolate);
+void  CAVESetThreadPriority(CAVETHREAD thread, CAVEPRIORITY priority);
+
+// how late the threads run after a timed wait, a wake-up for a task or their
+// usual period, over the latest second. CAVESetSchedulingLogInterval() prints
+// it periodically.
+typedef struct {
+	long long count;
+	float     meanMs;
+	float     p99Ms;
+	float     maxMs;
+} CAVESCHEDULINGLATENCY;
+
+void  CAVEGetSchedulingLatency(CAVETHREAD thread, CAVESCHEDULINGLATENCY *latency);
+void  CAVESetSchedulingLogInterval(float seconds); // 0: off
+
 long long CAVEGetFrameNumber();
 extern float *CAVEFramesPerSecond;
 CAVEID CAVEProcessType();
@@ -278,6 +648,26 @@ void CAVENavConvertCAVEToWorld(float inposition[3], float outposition[3]);
 void CAVENavConvertVectorCAVEToWorld(float invector[3], float outvector[3]);
 void CAVENavConvertWorldToCAVE(float inposition[3], float outposition[3]);
 void CAVENavConvertVectorWorldToCAVE(float invector[3], float outvector[3]);
+// conversions of count packed (x, y, z) points or vectors, SIMD and optionally
+// split across threads; in and out may be the same array
+void CAVENavConvertCAVEToWorldArray(const float *inpositions, float *outpositions, int count, bool parallel);
+void CAVENavConvertVectorCAVEToWorldArray(const float *invectors, float *outvectors, int count, bool parallel);
+void CAVENavConvertWorldToCAVEArray(const float *inpositions, float *outpositions, int count, bool parallel);
+void CAVENavConvertVectorWorldToCAVEArray(const float *invectors, float *outvectors, int count, bool parallel);
+
+// double precision navigation
+// CAVENavTransformRelative() loads the modelview matrix with the navigation
+// translated to origin (world coordinates), composed in double. Call it instead
+// of CAVENavTransform() and draw geometry stored relative to origin, e.g. one
+// origin per tile, to avoid jitter far from the world origin.
+void CAVENavTransformRelative(double origin[3]);
+void CAVENavGetMatrixd(double matrix[4][4]);
+void CAVENavLoadMatrixd(double matrix[4][4]);
+void CAVENavConvertCAVEToWorldd(double inposition[3], double outposition[3]);
+void CAVENavConvertVectorCAVEToWorldd(double invector[3], double outvector[3]);
+void CAVENavConvertWorldToCAVEd(double inposition[3], double outposition[3]);
+void CAVENavConvertVectorWorldToCAVEd(double invector[3], double outvector[3]);
+void CAVEGetPositiond(CAVEID id, double position[3]);
 void CAVEGetViewport(int *origX, int *origY, int *width, int *height);
 void CAVESetOption(CAVEID option, int value);
 
@@ -13,6 +13,9 @@
 
 #include "ovrvision.h"
 
+#include "../../memory/memory_stats.h"
+#include "../../thread/scheduling.h"
+
 #ifdef USE_OVRVISION
 
 OVRVision::OVRVision()
@@ -20,12 +23,14 @@ OVRVision::OVRVision()
 	p_OVRVision = nullptr;
 	m_Width = m_Height = 0, m_PixelSize = 4;
 	m_IsOpen = m_CameraState = false;
+	m_IsGLReady = false;
 #ifdef USE_THREAD_FOR_CAMERA_PROCESS
 	m_IsThreadRunning = true;
 #endif // USE_THREAD_FOR_CAMERA_PROCESS
 }
 
-bool OVRVision::Init()
+// opens the camera; no GL context is needed
+bool OVRVision::Open()
 {
 #ifdef USE_OVRVISION_PRO
 	p_OVRVision = new OVR::OvrvisionPro();
@@ -70,7 +75,21 @@ bool OVRVision::Init()
 		m_PixelSize = p_OVRVision->GetPixelSize();
 		m_Format = GL_RGB;
 #endif // USE_OVRVISION_PRO
+		return true;
+	}
+	else
+	{
+		std::cout << "OVRVision: DISABLE" << std::endl;
+		delete p_OVRVision;
+		return false;
+	}
+}
 
+// textures, on the thread of the render context
+bool OVRVision::InitGL()
+{
+	if (m_IsOpen)
+	{
 		glGenTextures(2, m_TexID);
 		for (int i = 0; i < 2; i++)
 		{
@@ -84,19 +103,16 @@ bool OVRVision::Init()
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_Width, m_Height, 0, m_Format, GL_UNSIGNED_BYTE, NULL);
 		}
 		glBindTexture(GL_TEXTURE_2D, 0);
+		MemoryStats::Allocate(MEMORY_GPU_CAMERA, MemoryStats::ImageBytes(m_Width, m_Height, 3, 2));
 
 		std::cout << "OVRVision: ENABLE" << std::endl;
 		std::cout << "OVRVision: Width     : " << m_Width << std::endl;
 		std::cout << "OVRVision: Height    : " << m_Height << std::endl;
 		std::cout << "OVRVision: PixelSize : " << m_PixelSize << std::endl;
+		m_IsGLReady = true;
 		return true;
 	}
-	else
-	{
-		std::cout << "OVRVision: DISABLE" << std::endl;
-		delete p_OVRVision;
-		return false;
-	}
+	return false;
 }
 
 void OVRVision::Terminate()
@@ -107,9 +123,16 @@ void OVRVision::Terminate()
 		CloseHandle(m_HCamera);
 		CloseHandle(m_HMutex);
 #endif // USE_THREAD_FOR_CAMERA_PROCESS
-		glDeleteTextures(2, m_TexID);
+		if (m_IsGLReady)
+		{
+			glDeleteTextures(2, m_TexID);
+			MemoryStats::Free(MEMORY_GPU_CAMERA, MemoryStats::ImageBytes(m_Width, m_Height, 3, 2));
+			m_IsGLReady = false;
+		}
 		p_OVRVision->Close();
 		delete p_OVRVision;
+		p_OVRVision = nullptr;
+		m_IsOpen = false;
 	}
 }
 
@@ -211,6 +234,8 @@ void OVRVision::CameraThread()
 {
 	while (m_IsThreadRunning)
 	{
+		ThreadScheduling::Apply(THREAD_CAMERA);
+		ThreadScheduling::RecordPeriod(THREAD_CAMERA);
 		WaitForSingleObject(m_HMutex, INFINITE);
 
 #ifdef USE_OVRVISION_PRO
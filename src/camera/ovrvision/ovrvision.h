@@ -43,6 +43,7 @@ class OVRVision {
 
 	int    OVRVisionState; // if OvrvisionPro->Open() succeeded, it return a value less than zero.
 	bool   m_IsOpen;
+	bool   m_IsGLReady; // InitGL() has created the textures
 	bool   m_CameraState;
 	int    m_Width, m_Height, m_PixelSize;
 	GLenum m_Format;
@@ -58,8 +59,9 @@ class OVRVision {
 public:
 	OVRVision();
 
-	bool   Init();
-	void   Terminate();
+	bool   Open();   // any thread
+	bool   InitGL(); // render context
+	void   Terminate(); // also after Open() alone
 	void   PreStore();
 	void   DrawImege(int eyeIndex);
 	bool   IsOpen() { return m_IsOpen; }
@@ -13,9 +13,25 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "shader.h"
+#include "../../gl/program_cache.h"
 #include <iostream>
+#include <chrono>
+
+// attribute bindings are part of the linked binary, so they are part of the cache key
+static const char* SHADER_ATTRIB_BINDINGS = "in_vertex=0;in_texCoord=1";
 
 Shader::Shader(const GLchar* vs, const GLchar* fs) {
+    verterxId_ = 0;
+    fragmentId_ = 0;
+
+    ProgramCache& cache = ProgramCache::Instance();
+    programId_ = cache.Load(vs, fs, SHADER_ATTRIB_BINDINGS);
+    if (programId_ != 0) {
+        return;
+    }
+    cache.CountMiss();
+    auto start = std::chrono::steady_clock::now();
+
     if (!compile(verterxId_, GL_VERTEX_SHADER, vs)) {
         std::cout << "ERROR: while compiling vertex shader" << std::endl;
     }
@@ -31,6 +47,9 @@ Shader::Shader(const GLchar* vs, const GLchar* fs) {
     glBindAttribLocation(programId_, ATTRIB_VERTICES_POS, "in_vertex");
     glBindAttribLocation(programId_, ATTRIB_TEXTURE2D_POS, "in_texCoord");
 
+    if (cache.IsAvailable()) {
+        glProgramParameteri(programId_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(programId_);
 
     GLint errorlk(0);
@@ -47,7 +66,12 @@ Shader::Shader(const GLchar* vs, const GLchar* fs) {
 
         delete[] error;
         glDeleteProgram(programId_);
+        programId_ = 0;
+        return;
     }
+
+    double compileSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cache.Store(programId_, vs, fs, SHADER_ATTRIB_BINDINGS, compileSeconds);
 }
 
 Shader::~Shader() {
@@ -56,7 +80,7 @@ Shader::~Shader() {
     if (fragmentId_ != 0)
         glDeleteShader(fragmentId_);
     if (programId_ != 0)
-        glDeleteShader(programId_);
+        glDeleteProgram(programId_);
 }
 
 GLuint Shader::getProgramId() {
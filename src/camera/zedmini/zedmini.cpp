@@ -15,6 +15,8 @@
 
 #include "zedmini.h"
 
+#include "../../memory/memory_stats.h"
+
 #ifdef USE_ZEDMINI
 
 #include <OVR_CAPI.h>
@@ -95,16 +97,16 @@ ZedMini::ZedMini()
 {
 	m_Width = m_Height = 0;
 	m_IsOpen = m_CameraState = false;
+	m_IsGLReady = false;
 }
 
 ZedMini::~ZedMini()
 {
 }
 
-bool ZedMini::Init()
+// opens the camera, which takes a while; no GL context is needed
+bool ZedMini::Open()
 {
-	glClearDepth(0.0); // for ZEDMini
-
 	sl::InitParameters initParameters;
 	initParameters.camera_resolution = sl::RESOLUTION_HD720;
 //	initParameters.camera_resolution = sl::RESOLUTION_HD1080;
@@ -215,6 +217,17 @@ bool ZedMini::Init()
 	std::cout << "bAutoGainAndExposure = " << std::endl;
 	std::cout << "bDefault = " << std::endl;
 #endif // DEBUG
+	return true;
+}
+
+// textures and shaders, on the thread of the render context
+bool ZedMini::InitGL()
+{
+	if (!m_IsOpen)
+	{
+		return false;
+	}
+	glClearDepth(0.0); // for ZEDMini
 
 	sl::uchar4 dark_bckgrd(44, 44, 44, 255);
 	glGenTextures(2, m_TexID);
@@ -248,6 +261,9 @@ bool ZedMini::Init()
 		m_Depth[eye].alloc(m_Width, m_Height, sl::MAT_TYPE_32F_C1, sl::MEM_GPU);
 	}
 
+	// color and depth textures with their sl::Mat copies, 4 bytes per pixel each
+	MemoryStats::Allocate(MEMORY_GPU_CAMERA, MemoryStats::ImageBytes(m_Width, m_Height, 4, 8));
+
 	// Register texture
 	cudaError_t err1 = cudaGraphicsGLRegisterImage(&cimg_l, m_TexID[ovrEye_Left],  GL_TEXTURE_2D, cudaGraphicsRegisterFlagsWriteDiscard);
 	cudaError_t err2 = cudaGraphicsGLRegisterImage(&cimg_r, m_TexID[ovrEye_Right], GL_TEXTURE_2D, cudaGraphicsRegisterFlagsWriteDiscard);
@@ -268,6 +284,7 @@ bool ZedMini::Init()
 	cudaGraphicsMapResources(1, &cimg_ld, 0);
 	cudaGraphicsMapResources(1, &cimg_rd, 0);
 
+	m_IsGLReady = true;
 	return true;
 }
 
@@ -275,20 +292,29 @@ void ZedMini::Terminate()
 {
 	if (m_IsOpen)
 	{
-		cudaGraphicsUnmapResources(1, &cimg_l);
-		cudaGraphicsUnmapResources(1, &cimg_r);
-		cudaGraphicsUnmapResources(1, &cimg_ld);
-		cudaGraphicsUnmapResources(1, &cimg_rd);
-
-		for (int eye = 0; eye < 2; eye++)
+		if (m_IsGLReady)
 		{
-			m_Image[eye].free();
-			m_Depth[eye].free();
+			cudaGraphicsUnmapResources(1, &cimg_l);
+			cudaGraphicsUnmapResources(1, &cimg_r);
+			cudaGraphicsUnmapResources(1, &cimg_ld);
+			cudaGraphicsUnmapResources(1, &cimg_rd);
+
+			for (int eye = 0; eye < 2; eye++)
+			{
+				m_Image[eye].free();
+				m_Depth[eye].free();
+			}
+			MemoryStats::Free(MEMORY_GPU_CAMERA, MemoryStats::ImageBytes(m_Width, m_Height, 4, 8));
 		}
 		m_Camera.close();
 
-		delete p_Shader;
-		delete p_ShaderDepth;
+		if (m_IsGLReady)
+		{
+			delete p_Shader;
+			delete p_ShaderDepth;
+			m_IsGLReady = false;
+		}
+		m_IsOpen = false;
 	}
 }
 
@@ -34,6 +34,7 @@ class ZedMini
 {
 	sl::Camera m_Camera;
 	bool    m_IsOpen;
+	bool    m_IsGLReady; // InitGL() has created the textures and shaders
 	bool    m_CameraState;
 	int     m_Width;
 	int     m_Height;
@@ -56,8 +57,9 @@ public:
 	ZedMini();
 	~ZedMini();
 
-	bool   Init();
-	void   Terminate();
+	bool   Open();   // any thread
+	bool   InitGL(); // render context
+	void   Terminate(); // also after Open() alone
 	void   PreStore();
 	void   DrawImage(int eyeIndex);
 	void   DrawRGBImage(int eyeIndex);
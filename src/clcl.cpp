@@ -12,9 +12,15 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "hmd/oculus/oculus.h"
+#include "memory/arena.h"
+#include "memory/memory_stats.h"
+#include "thread/scheduling.h"
 
 #include "clcl.h"
 
+#include <algorithm>
+#include <cstddef>
+
 CLCL *p_CLCL = nullptr;
 
 const int CONTROLLER_BUTTON1 = GLFW_MOUSE_BUTTON_LEFT;
@@ -39,10 +45,10 @@ public:
 	void  StartThread();
 	void  StopThread();
 
-	void  SetInitFunc(CAVECALLBACK callback, std::vector<void *> arg_list);
-	void  SetStopFunc(CAVECALLBACK callback, std::vector<void *> arg_list);
-	void  SetDrawFunc(CAVECALLBACK callback, std::vector<void *> arg_list);
-	void  SetIdleFunc(CAVECALLBACK callback, std::vector<void *> arg_list);
+	void  SetInitFunc(Callback callback);
+	void  SetStopFunc(Callback callback);
+	void  SetDrawFunc(Callback callback);
+	void  SetIdleFunc(Callback callback);
 };
 
 float CAVENear = 0.1f;
@@ -160,6 +166,16 @@ bool CAVEgetbutton(CAVEDevice device)
 	}
 }
 
+// the wand is the right Touch, or the head without it
+static bool IsWandHand()
+{
+#if (OVR_PRODUCT_VERSION == 1)
+	return (p_CLCL->p_Impl->hmd()->controllerType() == Oculus::ControllerType::OCULUS_TOUCH_RIGHT);
+#else
+	return false;
+#endif
+}
+
 void CAVEGetPosition(CAVEID id, float position[3])
 {
 	bool isTouch = false;
@@ -368,60 +384,70 @@ void CAVEGetVector(CAVEID id, float vector[3])
 
 void  CAVEGetOrientation(CAVEID id, float angle[3])
 {
-	// not implemented yet
-	bool isTouch = false;
-	switch (id)
-	{
-		case CAVE_HEAD:
-			break;
-		case CAVE_HEAD_NAV:
-			break;
-		case CAVE_WAND:
-			isTouch = true;
-			break;
-		case CAVE_WAND_NAV:
-			isTouch = true;
-			break;
-		case CAVE_LEFT_EYE:
-			break;
-		case CAVE_RIGHT_EYE:
-			break;
-		case CAVE_LEFT_EYE_NAV:
-			break;
-		case CAVE_RIGHT_EYE_NAV:
-			break;
-		default:
-			break;
-	}
-
-	OVR::Vector3f headOrientation, headOrientationNav;
-	headOrientation = p_CLCL->p_Impl->hmd()->headOrientation();
-	headOrientationNav = p_CLCL->p_Impl->hmd()->headOrientationNav();
-	if (id == CAVE_HEAD)
+	// CAVE_HEAD, CAVE_WAND, CAVE_LEFT_EYE, CAVE_RIGHT_EYE, then the same with _NAV
+	static const int sensors[4] = { SENSOR_HEAD, SENSOR_RIGHT_HAND, SENSOR_LEFT_EYE, SENSOR_RIGHT_EYE };
+	int offset = id - CAVE_HEAD;
+	if ((offset < 0) || (offset >= 8))
 	{
-		angle[0] = headOrientation.x;
-		angle[1] = headOrientation.y;
-		angle[2] = headOrientation.z;
 		return;
 	}
-	else if (id == CAVE_HEAD_NAV)
+	int sensor = sensors[offset % 4];
+	if ((sensor == SENSOR_RIGHT_HAND) && !IsWandHand())
 	{
-		angle[0] = headOrientationNav.x;
-		angle[1] = headOrientationNav.y;
-		angle[2] = headOrientationNav.z;
-		return;
+		sensor = SENSOR_HEAD;
 	}
-	return; // for test
+
+	SensorFrame frame;
+	p_CLCL->p_Impl->hmd()->GetSensorFrame(frame);
+	memcpy(angle, frame.Sensor[sensor][(offset >= 4) ? 1 : 0].Angle, sizeof(float) * 3);
 }
 
+// CAVEMalloc() arena, created at the first call with the CAVE_SHMEM_* options
+static size_t s_ShmemSize = 64 * 1024 * 1024;
+static size_t s_ShmemAddress = 0;
+static bool   s_ShmemLargePages = false;
+static Arena *p_Arena = nullptr;
+static std::once_flag s_ArenaOnce;
+static std::atomic<bool> s_ArenaFallback(false);
+
+// CAVEInit() returns before the startup is complete
+static bool s_AsyncInit = false;
+
 void CAVESetOption(CAVEID option, int value)
 {
-	// not implemented yet
 	switch (option)
 	{
 		case CAVE_SHMEM_SIZE:
+			// the arena is fixed once CAVEMalloc() has been called
+			if ((p_Arena == nullptr) && (value > 0))
+			{
+				s_ShmemSize = static_cast<size_t>(value);
+			}
+			break;
+		case CAVE_SHMEM_ADDRESS:
+			// in units of 64 KB (the allocation granularity) to fit 64-bit addresses in an int
+			if (p_Arena == nullptr)
+			{
+				s_ShmemAddress = static_cast<size_t>(static_cast<unsigned int>(value)) << 16;
+			}
+			break;
+		case CAVE_SHMEM_LARGEPAGES:
+			if (p_Arena == nullptr)
+			{
+				s_ShmemLargePages = (value != 0);
+			}
+			break;
+		case CAVE_FRAMEALLOC_SIZE:
+			if (value > 0)
+			{
+				FrameAllocator::SetBlockSize(static_cast<size_t>(value));
+			}
+			break;
+		case CAVE_ASYNC_INIT:
+			s_AsyncInit = (value != 0);
 			break;
 		default:
+			// not implemented yet
 			break;
 	}
 }
@@ -680,6 +706,20 @@ void CAVEConfigure(int *argc, char **argv, char **appdefaults)
 void CAVEInit()
 {
 	p_CLCL->p_Impl->StartThread();
+	if (!s_AsyncInit && !CAVEWaitForInit())
+	{
+		exit(EXIT_FAILURE);
+	}
+}
+
+bool CAVEWaitForInit()
+{
+	if (!p_CLCL->p_Impl->hmd()->WaitForInit())
+	{
+		return false;
+	}
+	CAVESync->Initted = true;
+	return true;
 }
 
 void CAVEExit()
@@ -696,119 +736,1042 @@ void CAVEHalt()
 	CAVEExit();
 }
 
+// the arguments are copied once here, not at every call
+static Callback VarargsCallback(CAVECALLBACK callback, int arg_num, va_list list)
+{
+	void* args[CALLBACK_MAX_ARGS];
+	for (int i = 0; (i < arg_num) && (i < CALLBACK_MAX_ARGS); i++)
+	{
+		args[i] = va_arg(list, void*);
+	}
+	return Callback(callback, args, arg_num);
+}
+
 void CAVEInitApplication(CAVECALLBACK callback, int arg_num, ...)
 {
-	std::vector<void*> arg_list;
 	va_list list;
 	va_start(list, arg_num);
-	for (int i = 0; i < arg_num; i++)
-	{
-		arg_list.push_back(va_arg(list, void*));
-	}
+	Callback function = VarargsCallback(callback, arg_num, list);
 	va_end(list);
 
-	p_CLCL->p_Impl->SetInitFunc(callback, arg_list);
+	p_CLCL->p_Impl->SetInitFunc(std::move(function));
 }
 
 void CAVEStopApplication(CAVECALLBACK callback, int arg_num, ...)
 {
-	std::vector<void*> arg_list;
 	va_list list;
 	va_start(list, arg_num);
-	for (int i = 0; i < arg_num; i++)
-	{
-		arg_list.push_back(va_arg(list, void*));
-	}
+	Callback function = VarargsCallback(callback, arg_num, list);
 	va_end(list);
 
-	p_CLCL->p_Impl->SetStopFunc(callback, arg_list);
+	p_CLCL->p_Impl->SetStopFunc(std::move(function));
 }
 
 void CAVEDisplay(CAVECALLBACK callback, int arg_num, ...)
 {
-	std::vector<void*> arg_list;
 	va_list list;
 	va_start(list, arg_num);
-	for (int i = 0; i < arg_num; i++)
-	{
-		arg_list.push_back(va_arg(list, void*));
-	}
+	Callback function = VarargsCallback(callback, arg_num, list);
 	va_end(list);
 
-	p_CLCL->p_Impl->SetDrawFunc(callback, arg_list);
+	p_CLCL->p_Impl->SetDrawFunc(std::move(function));
 }
 
 void CAVEFrameFunction(CAVECALLBACK callback, int arg_num, ...)
 {
-	std::vector<void*> arg_list;
 	va_list list;
 	va_start(list, arg_num);
-	for (int i = 0; i < arg_num; i++)
+	Callback function = VarargsCallback(callback, arg_num, list);
+	va_end(list);
+
+	p_CLCL->p_Impl->SetIdleFunc(std::move(function));
+}
+
+void CAVEInitApplication(CAVEFUNCTION callback)
+{
+	p_CLCL->p_Impl->SetInitFunc(std::move(callback));
+}
+
+void CAVEStopApplication(CAVEFUNCTION callback)
+{
+	p_CLCL->p_Impl->SetStopFunc(std::move(callback));
+}
+
+void CAVEDisplay(CAVEFUNCTION callback)
+{
+	p_CLCL->p_Impl->SetDrawFunc(std::move(callback));
+}
+
+void CAVEFrameFunction(CAVEFUNCTION callback)
+{
+	p_CLCL->p_Impl->SetIdleFunc(std::move(callback));
+}
+
+CAVELAYER CAVENewQuadLayer(int width, int height, bool headLocked)
+{
+	return p_CLCL->p_Impl->hmd()->CreateQuadLayer(width, height, headLocked);
+}
+
+void CAVEFreeQuadLayer(CAVELAYER layer)
+{
+	p_CLCL->p_Impl->hmd()->DestroyQuadLayer(layer);
+}
+
+void CAVEQuadLayerFunction(CAVELAYER layer, CAVECALLBACK callback, int arg_num, ...)
+{
+	va_list list;
+	va_start(list, arg_num);
+	Callback function = VarargsCallback(callback, arg_num, list);
+	va_end(list);
+
+	p_CLCL->p_Impl->hmd()->SetQuadLayerFunction(layer, std::move(function));
+}
+
+void CAVEQuadLayerFunction(CAVELAYER layer, CAVEFUNCTION callback)
+{
+	p_CLCL->p_Impl->hmd()->SetQuadLayerFunction(layer, std::move(callback));
+}
+
+void CAVESetQuadLayerPose(CAVELAYER layer, float position[3], float angle[3], float size[2])
+{
+	p_CLCL->p_Impl->hmd()->SetQuadLayerPose(layer, position, angle, size);
+}
+
+void CAVEUpdateQuadLayer(CAVELAYER layer)
+{
+	p_CLCL->p_Impl->hmd()->UpdateQuadLayer(layer);
+}
+
+CAVEUPLOAD CAVEUploadData(CAVECALLBACK callback, int arg_num, ...)
+{
+	va_list list;
+	va_start(list, arg_num);
+	Callback function = VarargsCallback(callback, arg_num, list);
+	va_end(list);
+
+	return p_CLCL->p_Impl->hmd()->EnqueueUpload(std::move(function));
+}
+
+CAVEUPLOAD CAVEUploadData(CAVEFUNCTION callback)
+{
+	return p_CLCL->p_Impl->hmd()->EnqueueUpload(std::move(callback));
+}
+
+bool CAVEUploadDone(CAVEUPLOAD upload)
+{
+	return p_CLCL->p_Impl->hmd()->IsUploadDone(upload);
+}
+
+void CAVEUploadWait(CAVEUPLOAD upload)
+{
+	p_CLCL->p_Impl->hmd()->WaitUpload(upload);
+}
+
+GLuint CAVECreateProgram(const char *vertexShader, const char *fragmentShader)
+{
+	return ProgramCache::Instance().CreateProgram(vertexShader, fragmentShader);
+}
+
+void CAVEGetProgramCacheStats(int *hits, int *misses, float *savedSeconds)
+{
+	double seconds = 0.0;
+	ProgramCache::Instance().GetStats(hits, misses, &seconds);
+	if (savedSeconds != nullptr)
 	{
-		arg_list.push_back(va_arg(list, void*));
+		*savedSeconds = static_cast<float>(seconds);
 	}
-	va_end(list);
+}
+
+void CAVEGetFrustum(CAVEID id, float planes[6][4])
+{
+	switch (id)
+	{
+		case CAVE_LEFT_EYE:
+			p_CLCL->p_Impl->hmd()->GetFrustum(ovrEye_Left, false, planes);
+			break;
+		case CAVE_RIGHT_EYE:
+			p_CLCL->p_Impl->hmd()->GetFrustum(ovrEye_Right, false, planes);
+			break;
+		case CAVE_LEFT_EYE_NAV:
+			p_CLCL->p_Impl->hmd()->GetFrustum(ovrEye_Left, true, planes);
+			break;
+		case CAVE_RIGHT_EYE_NAV:
+			p_CLCL->p_Impl->hmd()->GetFrustum(ovrEye_Right, true, planes);
+			break;
+		case CAVE_HEAD_NAV:
+			p_CLCL->p_Impl->hmd()->GetFrustum(ovrEye_Count, true, planes);
+			break;
+		case CAVE_HEAD:
+		default:
+			p_CLCL->p_Impl->hmd()->GetFrustum(ovrEye_Count, false, planes);
+			break;
+	}
+}
 
-	p_CLCL->p_Impl->SetIdleFunc(callback, arg_list);
+static int NumWorkerThreads(bool parallel)
+{
+	// the pool workers and the calling thread
+	return parallel ? ThreadPool::Instance().numWorkers() + 1 : 1;
 }
 
-void* CAVEMalloc(size_t size)
+int CAVECullSpheres(float planes[6][4], const float *spheres, int count, unsigned char *visible, bool parallel)
 {
-	return malloc(size);
+	return CullSpheres(planes, spheres, count, visible, NumWorkerThreads(parallel));
 }
 
-void  CAVEFree(void* ptr)
+int CAVECullBoxes(float planes[6][4], const float *boxes, int count, unsigned char *visible, bool parallel)
 {
-	free(ptr);
+	return CullBoxes(planes, boxes, count, visible, NumWorkerThreads(parallel));
 }
 
-long long CAVEGetFrameNumber()
+CAVELOD CAVENewLODObject(float center[3], float radius, int numLevels, const float *errors, const int *triangles, bool navigated)
 {
-	return p_CLCL->p_Impl->frameIndex();
+	return p_CLCL->p_Impl->hmd()->lodSelector().Register(center, radius, numLevels, errors, triangles, navigated);
 }
 
-CAVEID CAVEProcessType()
+void CAVEFreeLODObject(CAVELOD object)
 {
-	if (p_CLCL->p_Impl->hmd()->IsMainThread())
+	p_CLCL->p_Impl->hmd()->lodSelector().Unregister(object);
+}
+
+void CAVESetLODBounds(CAVELOD object, float center[3], float radius)
+{
+	p_CLCL->p_Impl->hmd()->lodSelector().SetBounds(object, center, radius);
+}
+
+void CAVESetLODOptions(float pixelError, float hysteresis, long long triangleBudget)
+{
+	p_CLCL->p_Impl->hmd()->lodSelector().SetOptions(pixelError, hysteresis, triangleBudget);
+}
+
+int CAVEGetLODLevels(int *levels, int maxCount)
+{
+	return p_CLCL->p_Impl->hmd()->lodSelector().GetLevels(levels, maxCount);
+}
+
+double CAVEGetTrackingTime()
+{
+	return ovr_GetTimeInSeconds();
+}
+
+static void CopyPose(double time, const Pose& pose, CAVEPOSE *cavePose)
+{
+	cavePose->time = time;
+	for (int i = 0; i < 3; i++)
 	{
-		return CAVE_APP_PROCESS;
+		cavePose->position[i] = pose.Position[i];
 	}
-	if (p_CLCL->p_Impl->hmd()->IsDisplayThread())
+	for (int i = 0; i < 4; i++)
 	{
-		return CAVE_DISPLAY_PROCESS;
+		cavePose->orientation[i] = pose.Orientation[i];
 	}
-	// TODO: should change to return other PROCESS_TYPE
-	return CAVE_APP_PROCESS;
 }
 
-CAVELOCK CAVENewLock() { return nullptr; }
-void CAVEFreeLock(CAVELOCK lock) {}
-void CAVESetReadLock(CAVELOCK lock) {}
-void CAVESetWriteLock(CAVELOCK lock) {}
-void CAVEUnsetReadLock(CAVELOCK lock) {}
-void CAVEUnsetWriteLock(CAVELOCK lock) {}
+bool CAVEGetPoseAtTime(CAVETRACKEDDEVICE device, bool navigated, double time, CAVEPOSE *pose)
+{
+	Pose tmpPose;
+	if (!p_CLCL->p_Impl->hmd()->poseHistory().Sample(time, device, navigated, tmpPose))
+	{
+		return false;
+	}
+	CopyPose(time, tmpPose, pose);
+	return true;
+}
+
+bool CAVEGetPoseVelocity(CAVETRACKEDDEVICE device, bool navigated, double time, float linear[3], float angular[3])
+{
+	return p_CLCL->p_Impl->hmd()->poseHistory().Velocity(time, device, navigated, linear, angular);
+}
 
-void CAVENavLock() {}
-void CAVENavUnlock() {}
+int CAVEGetPoseHistory(CAVETRACKEDDEVICE device, bool navigated, double fromTime, CAVEPOSE *poses, int maxCount)
+{
+	if ((poses == nullptr) || (maxCount <= 0))
+	{
+		return 0;
+	}
+	maxCount = std::min(maxCount, POSE_HISTORY_SIZE);
+	int numPoses = p_CLCL->p_Impl->hmd()->poseHistory().VisitHistory(fromTime, device, navigated, maxCount, [poses](int i, double time, const Pose& pose)
+	{
+		CopyPose(time, pose, &poses[i]);
+	});
+	std::reverse(poses, poses + numPoses); // oldest first
+	return numPoses;
+}
 
-void CAVENavConvertCAVEToWorld(float inposition[3], float outposition[3])
+void  CAVEGetSensorSnapshot(CAVESENSORSNAPSHOT *snapshot)
 {
-	// not implemented yet
+	static_assert(sizeof(CAVESENSORSTATE) == sizeof(SensorState), "CAVESENSORSTATE must match SensorState");
+	SensorFrame frame;
+	p_CLCL->p_Impl->hmd()->GetSensorFrame(frame);
+	snapshot->frame = frame.Frame;
+	snapshot->time = frame.Time;
+	snapshot->tracked = frame.TrackedSensors;
+	for (int i = 0; i < CAVE_SENSOR_COUNT; i++)
+	{
+		memcpy(&snapshot->sensor[i], &frame.Sensor[i][0], sizeof(CAVESENSORSTATE));
+		memcpy(&snapshot->sensorNav[i], &frame.Sensor[i][1], sizeof(CAVESENSORSTATE));
+	}
 }
 
-void CAVENavConvertVectorCAVEToWorld(float invector[3], float outvector[3])
+double CAVEGetPredictedDisplayTime(int framesAhead)
 {
-	// not implemented yet
+	return p_CLCL->p_Impl->hmd()->GetPredictedDisplayTime(framesAhead);
 }
 
-void CAVENavConvertWorldToCAVE(float inposition[3], float outposition[3])
+void CAVEGetPredictedPosition(CAVEID id, double time, float position[3])
 {
-	// not implemented yet
+	// CAVE_HEAD, CAVE_WAND, (eyes), then the same with _NAV
+	int offset = id - CAVE_HEAD;
+	Pose pose;
+	if ((offset < 0) || (offset >= 8) || ((offset % 4) >= 2) ||
+		!p_CLCL->p_Impl->hmd()->GetPredictedPose((((offset % 4) == 1) && IsWandHand()) ? POSE_RIGHT_HAND : POSE_HEAD, offset >= 4, time, pose))
+	{
+		CAVEGetPosition(id, position);
+		return;
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		position[i] = pose.Position[i];
+	}
 }
 
-void CAVENavConvertVectorWorldToCAVE(float invector[3], float outvector[3])
+void CAVEGetPredictedVector(CAVEID id, double time, float vector[3])
 {
-	// not implemented yet
+	// HEAD/WAND alternating over FRONT, BACK, LEFT, RIGHT, UP, DOWN, then the same with _NAV
+	static const float directions[6][3] = {
+		{ 0.0f, 0.0f, -1.0f }, { 0.0f, 0.0f, 1.0f }, { -1.0f, 0.0f, 0.0f },
+		{ 1.0f, 0.0f,  0.0f }, { 0.0f, 1.0f, 0.0f }, {  0.0f, -1.0f, 0.0f } };
+	int offset = id - CAVE_HEAD_FRONT;
+	Pose pose;
+	if ((offset < 0) || (offset >= 24) ||
+		!p_CLCL->p_Impl->hmd()->GetPredictedPose((((offset % 2) == 1) && IsWandHand()) ? POSE_RIGHT_HAND : POSE_HEAD, offset >= 12, time, pose))
+	{
+		CAVEGetVector(id, vector);
+		return;
+	}
+	RotateVector(pose.Orientation, directions[(offset % 12) / 2], vector);
+}
+
+void  CAVESetTrackerRate(int rate)
+{
+	p_CLCL->p_Impl->hmd()->SetTrackerRate(rate);
+}
+
+long long CAVEPublishAppData()
+{
+	return p_CLCL->p_Impl->hmd()->latencyStats().PublishAppData(ovr_GetTimeInSeconds());
+}
+
+int CAVEGetLatencyTrace(CAVELATENCYFRAME *frames, int maxCount)
+{
+	static_assert(sizeof(CAVELATENCYFRAME) == sizeof(LatencyFrame), "CAVELATENCYFRAME must match LatencyFrame");
+	static_assert(offsetof(CAVELATENCYFRAME, appDataTime) == offsetof(LatencyFrame, AppDataTime), "CAVELATENCYFRAME must match LatencyFrame");
+	if ((frames == nullptr) || (maxCount <= 0))
+	{
+		return 0;
+	}
+	maxCount = std::min(maxCount, LATENCY_TRACE_SIZE);
+	return p_CLCL->p_Impl->hmd()->latencyStats().GetTrace(reinterpret_cast<LatencyFrame*>(frames), maxCount);
+}
+
+int CAVEGetLatencyHistogram(CAVELATENCY metric, int counts[CAVE_LATENCY_BINS], float *minMs, float *maxMs)
+{
+	static_assert(CAVE_LATENCY_BINS == LATENCY_HISTOGRAM_BINS, "CAVE_LATENCY_BINS must match LATENCY_HISTOGRAM_BINS");
+	return p_CLCL->p_Impl->hmd()->latencyStats().GetHistogram(metric, counts, minMs, maxMs);
+}
+
+void CAVEResetLatencyStats()
+{
+	p_CLCL->p_Impl->hmd()->latencyStats().Reset();
+}
+
+void CAVESimulationFunction(float rate, CAVECALLBACK callback, int arg_num, ...)
+{
+	va_list list;
+	va_start(list, arg_num);
+	Callback function = VarargsCallback(callback, arg_num, list);
+	va_end(list);
+
+	p_CLCL->p_Impl->hmd()->StartSimulation(rate, std::move(function));
+}
+
+void CAVESimulationFunction(float rate, CAVEFUNCTION callback)
+{
+	p_CLCL->p_Impl->hmd()->StartSimulation(rate, std::move(callback));
+}
+
+void CAVEStopSimulation()
+{
+	p_CLCL->p_Impl->hmd()->simulation().Stop();
+}
+
+double CAVEGetSimulationTime()
+{
+	return p_CLCL->p_Impl->hmd()->simulation().stepTime();
+}
+
+float CAVEGetSimulationAlpha()
+{
+	return p_CLCL->p_Impl->hmd()->simulation().alpha();
+}
+
+int CAVERegisterSimulationArray(float *source, float *display, int count)
+{
+	return p_CLCL->p_Impl->hmd()->simulation().RegisterArray(source, display, count);
+}
+
+void CAVEUnregisterSimulationArray(int arrayID)
+{
+	p_CLCL->p_Impl->hmd()->simulation().UnregisterArray(arrayID);
+}
+
+static bool EnableLockMemoryPrivilege()
+{
+	HANDLE token;
+	if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+	{
+		return false;
+	}
+	TOKEN_PRIVILEGES privileges;
+	privileges.PrivilegeCount = 1;
+	privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+	bool enabled = LookupPrivilegeValue(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid)
+		&& AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr)
+		&& (GetLastError() == ERROR_SUCCESS);
+	CloseHandle(token);
+	return enabled;
+}
+
+// named mutex of a shared arena, which serializes its creation and all its
+// calls between the processes
+static HANDLE s_ShmemMutex = nullptr;
+
+static bool LockSharedArena(HANDLE mutex)
+{
+	DWORD result = WaitForSingleObject(mutex, INFINITE);
+	if ((result == WAIT_ABANDONED) && (p_Arena != nullptr))
+	{
+		// the lock is ours, but its owner terminated inside an arena call
+		std::cout << "CLCL: A process terminated while holding the shared arena lock, the shared arena is no longer used." << std::endl;
+		p_Arena->MarkAbandoned();
+	}
+	return (result == WAIT_OBJECT_0) || (result == WAIT_ABANDONED);
+}
+
+static void* ArenaAllocate(size_t size)
+{
+	if ((p_Arena == nullptr) || ((s_ShmemMutex != nullptr) && !LockSharedArena(s_ShmemMutex)))
+	{
+		return nullptr;
+	}
+	void *ptr = p_Arena->Allocate(size);
+	if (s_ShmemMutex != nullptr)
+	{
+		ReleaseMutex(s_ShmemMutex);
+	}
+	return ptr;
+}
+
+static void ArenaFree(void *ptr)
+{
+	if ((s_ShmemMutex != nullptr) && !LockSharedArena(s_ShmemMutex))
+	{
+		return;
+	}
+	p_Arena->Free(ptr);
+	if (s_ShmemMutex != nullptr)
+	{
+		ReleaseMutex(s_ShmemMutex);
+	}
+}
+
+static void CreateArena()
+{
+	if (p_Arena != nullptr)
+	{
+		// already created or attached by CAVESetSharedArena()
+		return;
+	}
+	size_t size = (s_ShmemSize + ARENA_SPAN_SIZE - 1) / ARENA_SPAN_SIZE * ARENA_SPAN_SIZE;
+	void *base = nullptr;
+	if (s_ShmemLargePages)
+	{
+		size_t largePage = GetLargePageMinimum();
+		if ((largePage > 0) && EnableLockMemoryPrivilege())
+		{
+			size_t largeSize = (size + largePage - 1) / largePage * largePage;
+			base = VirtualAlloc(reinterpret_cast<void*>(s_ShmemAddress), largeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+			if ((base == nullptr) && (s_ShmemAddress != 0))
+			{
+				base = VirtualAlloc(nullptr, largeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+			}
+			if (base != nullptr)
+			{
+				size = largeSize;
+			}
+		}
+		if (base == nullptr)
+		{
+			std::cout << "CLCL: Large pages are not available (SeLockMemoryPrivilege is required)." << std::endl;
+		}
+	}
+	if ((base == nullptr) && (s_ShmemAddress != 0))
+	{
+		base = VirtualAlloc(reinterpret_cast<void*>(s_ShmemAddress), size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+		if (base == nullptr)
+		{
+			std::cout << "CLCL: CAVE_SHMEM_ADDRESS 0x" << std::hex << s_ShmemAddress << std::dec << " is not available." << std::endl;
+		}
+	}
+	if (base == nullptr)
+	{
+		base = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	}
+
+	p_Arena = Arena::Create(base, size);
+	if (p_Arena == nullptr)
+	{
+		std::cout << "CLCL: Failed to create the shared arena of " << size << " bytes." << std::endl;
+		if (base != nullptr)
+		{
+			VirtualFree(base, 0, MEM_RELEASE);
+		}
+	}
+}
+
+void* CAVEMalloc(size_t size)
+{
+	std::call_once(s_ArenaOnce, CreateArena);
+	void *ptr = ArenaAllocate(size);
+	if ((ptr == nullptr) && (s_ShmemMutex != nullptr))
+	{
+		// malloc() memory is not valid in the other processes of a shared arena
+		if (!p_Arena->isAbandoned() && !s_ArenaFallback.exchange(true))
+		{
+			std::cout << "CLCL: The shared arena is exhausted, CAVEMalloc() returns NULL (increase CAVE_SHMEM_SIZE)." << std::endl;
+		}
+		return nullptr;
+	}
+	if (ptr == nullptr)
+	{
+		if ((p_Arena != nullptr) && !p_Arena->isAbandoned() && !s_ArenaFallback.exchange(true))
+		{
+			std::cout << "CLCL: The arena is exhausted, falling back to malloc (increase CAVE_SHMEM_SIZE)." << std::endl;
+		}
+		ptr = malloc(size);
+		if (ptr != nullptr)
+		{
+			MemoryStats::Allocate(MEMORY_CAVEMALLOC, _msize(ptr));
+		}
+	}
+	else
+	{
+		MemoryStats::Allocate(MEMORY_CAVEMALLOC, p_Arena->AllocatedSize(ptr));
+	}
+	return ptr;
+}
+
+void  CAVEFree(void* ptr)
+{
+	if ((p_Arena != nullptr) && p_Arena->Contains(ptr))
+	{
+		MemoryStats::Free(MEMORY_CAVEMALLOC, p_Arena->AllocatedSize(ptr));
+		ArenaFree(ptr);
+	}
+	else if (ptr != nullptr)
+	{
+		MemoryStats::Free(MEMORY_CAVEMALLOC, _msize(ptr));
+		free(ptr);
+	}
+}
+
+static HANDLE s_ShmemMapping = nullptr;
+
+static bool AttachSharedArena(HANDLE mapping, const char *name)
+{
+	// read the address and size the creator chose, then map the view there
+	void *view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	Arena *arena = (view != nullptr) ? Arena::Attach(view) : nullptr;
+	if (arena == nullptr)
+	{
+		std::cout << "CLCL: \"" << name << "\" is not a CLCL shared arena." << std::endl;
+		if (view != nullptr)
+		{
+			UnmapViewOfFile(view);
+		}
+		return false;
+	}
+	void *address = arena->address();
+	UnmapViewOfFile(view);
+
+	view = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0, address);
+	if (view == nullptr)
+	{
+		std::cout << "CLCL: Failed to attach the shared arena \"" << name << "\" at " << address << " (error " << GetLastError() << ")." << std::endl;
+		return false;
+	}
+	p_Arena = Arena::Attach(view);
+	std::cout << "CLCL: Attached the shared arena \"" << name << "\" at " << address << "." << std::endl;
+	return true;
+}
+
+static bool CreateOrAttachSharedArena(const char *name)
+{
+	size_t size = (s_ShmemSize + ARENA_SPAN_SIZE - 1) / ARENA_SPAN_SIZE * ARENA_SPAN_SIZE;
+	HANDLE mapping = nullptr;
+	if (s_ShmemLargePages)
+	{
+		size_t largePage = GetLargePageMinimum();
+		if ((largePage > 0) && EnableLockMemoryPrivilege())
+		{
+			size_t largeSize = (size + largePage - 1) / largePage * largePage;
+			mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE | SEC_COMMIT | SEC_LARGE_PAGES,
+				static_cast<DWORD>(static_cast<unsigned long long>(largeSize) >> 32), static_cast<DWORD>(largeSize), name);
+			if (mapping != nullptr)
+			{
+				size = largeSize;
+			}
+		}
+		if (mapping == nullptr)
+		{
+			std::cout << "CLCL: Large pages are not available (SeLockMemoryPrivilege is required)." << std::endl;
+		}
+	}
+	if (mapping == nullptr)
+	{
+		mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE | SEC_COMMIT,
+			static_cast<DWORD>(static_cast<unsigned long long>(size) >> 32), static_cast<DWORD>(size), name);
+	}
+	if (mapping == nullptr)
+	{
+		std::cout << "CLCL: Failed to create the shared arena \"" << name << "\" (error " << GetLastError() << ")." << std::endl;
+		return false;
+	}
+
+	if (GetLastError() == ERROR_ALREADY_EXISTS)
+	{
+		// another process has created it
+		if (!AttachSharedArena(mapping, name))
+		{
+			CloseHandle(mapping);
+			return false;
+		}
+		s_ShmemMapping = mapping;
+		return true;
+	}
+
+	void *base = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0, reinterpret_cast<void*>(s_ShmemAddress));
+	if ((base == nullptr) && (s_ShmemAddress != 0))
+	{
+		// the application relies on the address (e.g. pointers stored in files)
+		std::cout << "CLCL: CAVE_SHMEM_ADDRESS 0x" << std::hex << s_ShmemAddress << std::dec << " is not available for the shared arena \"" << name << "\"." << std::endl;
+		CloseHandle(mapping);
+		return false;
+	}
+	p_Arena = Arena::Create(base, size, true);
+	if (p_Arena == nullptr)
+	{
+		std::cout << "CLCL: Failed to create the shared arena \"" << name << "\"." << std::endl;
+		if (base != nullptr)
+		{
+			UnmapViewOfFile(base);
+		}
+		CloseHandle(mapping);
+		return false;
+	}
+	s_ShmemMapping = mapping;
+	std::cout << "CLCL: Created the shared arena \"" << name << "\" of " << size << " bytes at " << base << "." << std::endl;
+	return true;
+}
+
+static bool CreateSharedArena(const char *name)
+{
+	// held while the arena is created, so that no process attaches to a
+	// half-built one, and then for every call of the arena
+	std::string mutexName = std::string(name) + ".lock";
+	HANDLE mutex = CreateMutexA(nullptr, FALSE, mutexName.c_str());
+	if ((mutex == nullptr) || !LockSharedArena(mutex))
+	{
+		std::cout << "CLCL: Failed to create the lock of the shared arena \"" << name << "\" (error " << GetLastError() << ")." << std::endl;
+		if (mutex != nullptr)
+		{
+			CloseHandle(mutex);
+		}
+		return false;
+	}
+	bool isShared = CreateOrAttachSharedArena(name);
+	ReleaseMutex(mutex);
+	if (!isShared)
+	{
+		CloseHandle(mutex);
+		return false;
+	}
+	s_ShmemMutex = mutex;
+	return true;
+}
+
+bool CAVESetSharedArena(const char *name)
+{
+	if ((name == nullptr) || (name[0] == '\0'))
+	{
+		return false;
+	}
+	bool isFirst = false;
+	bool shared = false;
+	std::call_once(s_ArenaOnce, [&]()
+	{
+		isFirst = true;
+		shared = CreateSharedArena(name);
+		if (!shared)
+		{
+			CreateArena();
+		}
+	});
+	if (!isFirst)
+	{
+		std::cout << "CLCL: CAVESetSharedArena() must be called before the first CAVEMalloc()." << std::endl;
+	}
+	return shared;
+}
+
+void CAVESetSharedRoot(void *ptr)
+{
+	if ((p_Arena != nullptr) && ((ptr == nullptr) || p_Arena->Contains(ptr)))
+	{
+		p_Arena->SetRoot(ptr);
+	}
+}
+
+void* CAVEGetSharedRoot()
+{
+	return (p_Arena != nullptr) ? p_Arena->root() : nullptr;
+}
+
+void* CAVEFrameAlloc(size_t size, size_t align)
+{
+	return FrameAllocator::Allocate(size, align);
+}
+
+void CAVEGetFrameAllocStats(size_t *used, size_t *highWater)
+{
+	if (used != nullptr)
+	{
+		*used = FrameAllocator::usedBytes();
+	}
+	if (highWater != nullptr)
+	{
+		*highWater = FrameAllocator::highWater();
+	}
+}
+
+void CAVEGetMemoryStats(CAVEMEMORY category, CAVEMEMORYSTATS *stats)
+{
+	static_assert(sizeof(CAVEMEMORYSTATS) == sizeof(MemoryCounters), "CAVEMEMORYSTATS must match MemoryCounters");
+	static_assert(static_cast<int>(CAVE_MEMORY_CATEGORY_COUNT) == static_cast<int>(MEMORY_CATEGORY_COUNT), "CAVEMEMORY must match MEMORY_CATEGORY");
+	if (stats == nullptr)
+	{
+		return;
+	}
+	MemoryCounters counters;
+	MemoryStats::Get(category, counters);
+	memcpy(stats, &counters, sizeof(CAVEMEMORYSTATS));
+}
+
+void CAVESetMemoryLogInterval(float seconds)
+{
+	MemoryStats::SetLogInterval(seconds);
+}
+
+void CAVEParallelFor(int begin, int end, int grain, std::function<void(int)> function)
+{
+	ThreadPool::Instance().ParallelFor(begin, end, grain, [&function](int chunkBegin, int chunkEnd)
+	{
+		for (int i = chunkBegin; i < chunkEnd; i++)
+		{
+			function(i);
+		}
+	});
+}
+
+void CAVEParallelForRange(int begin, int end, int grain, std::function<void(int, int)> function)
+{
+	ThreadPool::Instance().ParallelFor(begin, end, grain, function);
+}
+
+int CAVENumWorkerThreads()
+{
+	return ThreadPool::Instance().numWorkers();
+}
+
+CAVETASKGROUP CAVENewTaskGroup()
+{
+	return new TaskGroup(ThreadPool::Instance());
+}
+
+void CAVESpawnTask(CAVETASKGROUP group, CAVEFUNCTION task)
+{
+	if (group != nullptr)
+	{
+		reinterpret_cast<TaskGroup*>(group)->Spawn(std::move(task));
+	}
+}
+
+void CAVEJoinTaskGroup(CAVETASKGROUP group)
+{
+	if (group != nullptr)
+	{
+		reinterpret_cast<TaskGroup*>(group)->Join();
+	}
+}
+
+void CAVEFreeTaskGroup(CAVETASKGROUP group)
+{
+	delete reinterpret_cast<TaskGroup*>(group); // joins the remaining tasks
+}
+
+CAVEJOB CAVESubmitJob(CAVEFUNCTION job, const CAVEJOB *dependencies, int numDependencies)
+{
+	return p_CLCL->p_Impl->hmd()->frameJobs().Submit(std::move(job), dependencies, numDependencies);
+}
+
+bool CAVEJobDone(CAVEJOB job)
+{
+	return p_CLCL->p_Impl->hmd()->frameJobs().IsDone(job);
+}
+
+void CAVEWaitJob(CAVEJOB job)
+{
+	p_CLCL->p_Impl->hmd()->frameJobs().Wait(job);
+}
+
+CAVEFRAMETASK CAVEStartFrameTask(std::function<bool()> step)
+{
+	return p_CLCL->p_Impl->hmd()->frameTasks().Add(std::move(step));
+}
+
+void CAVECancelFrameTask(CAVEFRAMETASK task)
+{
+	p_CLCL->p_Impl->hmd()->frameTasks().Cancel(task);
+}
+
+bool CAVEFrameTaskRunning(CAVEFRAMETASK task)
+{
+	return p_CLCL->p_Impl->hmd()->frameTasks().IsRunning(task);
+}
+
+void CAVESetFrameTaskBudget(float milliseconds)
+{
+	p_CLCL->p_Impl->hmd()->frameTasks().SetMaxBudget(milliseconds * 0.001);
+}
+
+double CAVEFrameTimeLeft()
+{
+	return p_CLCL->p_Impl->hmd()->frameTasks().TimeLeft();
+}
+
+void CAVEWaitNextFrame()
+{
+	p_CLCL->p_Impl->hmd()->frameTasks().WaitNextFrame();
+}
+
+void CAVESetThreadAffinity(CAVETHREAD thread, unsigned long long mask, bool isolate)
+{
+	static_assert(static_cast<int>(CAVE_THREAD_COUNT) == static_cast<int>(THREAD_ROLE_COUNT), "CAVETHREAD must match THREAD_ROLE");
+	ThreadPolicy policy = { 0, SCHEDULING_DEFAULT, false };
+	ThreadScheduling::GetPolicy(thread, policy);
+	policy.AffinityMask = mask;
+	policy.IsIsolated = isolate && (mask != 0);
+	ThreadScheduling::SetPolicy(thread, policy);
+}
+
+void CAVESetThreadPriority(CAVETHREAD thread, CAVEPRIORITY priority)
+{
+	ThreadPolicy policy = { 0, SCHEDULING_DEFAULT, false };
+	ThreadScheduling::GetPolicy(thread, policy);
+	policy.Priority = priority;
+	ThreadScheduling::SetPolicy(thread, policy);
+}
+
+void CAVEGetSchedulingLatency(CAVETHREAD thread, CAVESCHEDULINGLATENCY *latency)
+{
+	static_assert(sizeof(CAVESCHEDULINGLATENCY) == sizeof(SchedulingLatency), "CAVESCHEDULINGLATENCY must match SchedulingLatency");
+	if (latency == nullptr)
+	{
+		return;
+	}
+	SchedulingLatency stats;
+	ThreadScheduling::GetLatency(thread, stats);
+	memcpy(latency, &stats, sizeof(CAVESCHEDULINGLATENCY));
+}
+
+void CAVESetSchedulingLogInterval(float seconds)
+{
+	ThreadScheduling::SetLogInterval(seconds);
+}
+
+long long CAVEGetFrameNumber()
+{
+	return p_CLCL->p_Impl->frameIndex();
+}
+
+CAVEID CAVEProcessType()
+{
+	if (p_CLCL->p_Impl->hmd()->IsMainThread())
+	{
+		return CAVE_APP_PROCESS;
+	}
+	if (p_CLCL->p_Impl->hmd()->IsDisplayThread())
+	{
+		return CAVE_DISPLAY_PROCESS;
+	}
+	if (p_CLCL->p_Impl->hmd()->IsTrackerThread())
+	{
+		return CAVE_TRACKER_PROCESS;
+	}
+	// TODO: should change to return other PROCESS_TYPE
+	return CAVE_APP_PROCESS;
+}
+
+CAVELOCK CAVENewLock() { return nullptr; }
+void CAVEFreeLock(CAVELOCK lock) {}
+void CAVESetReadLock(CAVELOCK lock) {}
+void CAVESetWriteLock(CAVELOCK lock) {}
+void CAVEUnsetReadLock(CAVELOCK lock) {}
+void CAVEUnsetWriteLock(CAVELOCK lock) {}
+
+void CAVENavLock()
+{
+	p_CLCL->p_Impl->hmd()->LockNavigation();
+	p_CLCL->p_Impl->SetNavLockState(true);
+}
+
+void CAVENavUnlock()
+{
+	p_CLCL->p_Impl->SetNavLockState(false);
+	p_CLCL->p_Impl->hmd()->UnlockNavigation();
+}
+
+void CAVENavConvertCAVEToWorld(float inposition[3], float outposition[3])
+{
+	AffineTransformPoint(p_CLCL->p_Impl->hmd()->GetLatchedNavigation(true), inposition, outposition);
+}
+
+void CAVENavConvertVectorCAVEToWorld(float invector[3], float outvector[3])
+{
+	AffineTransformVector(p_CLCL->p_Impl->hmd()->GetLatchedNavigation(true), invector, outvector);
+}
+
+void CAVENavConvertWorldToCAVE(float inposition[3], float outposition[3])
+{
+	AffineTransformPoint(p_CLCL->p_Impl->hmd()->GetLatchedNavigation(false), inposition, outposition);
+}
+
+void CAVENavConvertVectorWorldToCAVE(float invector[3], float outvector[3])
+{
+	AffineTransformVector(p_CLCL->p_Impl->hmd()->GetLatchedNavigation(false), invector, outvector);
+}
+
+void CAVENavConvertCAVEToWorldArray(const float *inpositions, float *outpositions, int count, bool parallel)
+{
+	TransformPoints(p_CLCL->p_Impl->hmd()->GetLatchedNavigation(true), inpositions, outpositions, count, NumWorkerThreads(parallel));
+}
+
+void CAVENavConvertVectorCAVEToWorldArray(const float *invectors, float *outvectors, int count, bool parallel)
+{
+	TransformVectors(p_CLCL->p_Impl->hmd()->GetLatchedNavigation(true), invectors, outvectors, count, NumWorkerThreads(parallel));
+}
+
+void CAVENavConvertWorldToCAVEArray(const float *inpositions, float *outpositions, int count, bool parallel)
+{
+	TransformPoints(p_CLCL->p_Impl->hmd()->GetLatchedNavigation(false), inpositions, outpositions, count, NumWorkerThreads(parallel));
+}
+
+void CAVENavConvertVectorWorldToCAVEArray(const float *invectors, float *outvectors, int count, bool parallel)
+{
+	TransformVectors(p_CLCL->p_Impl->hmd()->GetLatchedNavigation(false), invectors, outvectors, count, NumWorkerThreads(parallel));
+}
+
+void CAVENavTransformRelative(double origin[3])
+{
+	p_CLCL->p_Impl->hmd()->SetNavigationMatrixRelative(origin);
+}
+
+void CAVENavGetMatrixd(double matrix[4][4])
+{
+	double tmpMat4[4][4];
+	p_CLCL->p_Impl->hmd()->GetNavigationMatrix(tmpMat4);
+	for (int j = 0; j < 4; j++)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			matrix[j][i] = tmpMat4[i][j];
+		}
+	}
+}
+
+void CAVENavLoadMatrixd(double matrix[4][4])
+{
+	double tmpMat4[4][4];
+	for (int j = 0; j < 4; j++)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			tmpMat4[i][j] = matrix[j][i];
+		}
+	}
+	p_CLCL->p_Impl->hmd()->LoadNavigationMatrix(tmpMat4);
+}
+
+void CAVENavConvertCAVEToWorldd(double inposition[3], double outposition[3])
+{
+	AffineTransformPoint(p_CLCL->p_Impl->hmd()->GetLatchedNavigation(true), inposition, outposition);
+}
+
+void CAVENavConvertVectorCAVEToWorldd(double invector[3], double outvector[3])
+{
+	AffineTransformVector(p_CLCL->p_Impl->hmd()->GetLatchedNavigation(true), invector, outvector);
+}
+
+void CAVENavConvertWorldToCAVEd(double inposition[3], double outposition[3])
+{
+	AffineTransformPoint(p_CLCL->p_Impl->hmd()->GetLatchedNavigation(false), inposition, outposition);
+}
+
+void CAVENavConvertVectorWorldToCAVEd(double invector[3], double outvector[3])
+{
+	AffineTransformVector(p_CLCL->p_Impl->hmd()->GetLatchedNavigation(false), invector, outvector);
+}
+
+void CAVEGetPositiond(CAVEID id, double position[3])
+{
+	// navigated positions are converted from the tracked ones in double
+	float trackedPosition[3] = { 0.0f, 0.0f, 0.0f };
+	bool isNavigated = true;
+	switch (id)
+	{
+		case CAVE_HEAD_NAV:
+			CAVEGetPosition(CAVE_HEAD, trackedPosition);
+			break;
+		case CAVE_WAND_NAV:
+			CAVEGetPosition(CAVE_WAND, trackedPosition);
+			break;
+		default:
+			CAVEGetPosition(id, trackedPosition);
+			isNavigated = false;
+			break;
+	}
+
+	double tmpPosition[3] = { trackedPosition[0], trackedPosition[1], trackedPosition[2] };
+	if (isNavigated)
+	{
+		CAVENavConvertCAVEToWorldd(tmpPosition, position);
+	}
+	else
+	{
+		position[0] = tmpPosition[0];
+		position[1] = tmpPosition[1];
+		position[2] = tmpPosition[2];
+	}
 }
 
 void CAVEGetViewport(int *origX, int *origY, int *width, int *height)
@@ -849,22 +1812,22 @@ void CLCL::Impl::StopThread()
 	p_HMD->StopThread();
 }
 
-void CLCL::Impl::SetInitFunc(CAVECALLBACK callback, std::vector<void *> arg_list)
+void CLCL::Impl::SetInitFunc(Callback callback)
 {
-	p_HMD->SetInitFunction(callback, arg_list);
+	p_HMD->SetInitFunction(std::move(callback));
 }
 
-void CLCL::Impl::SetStopFunc(CAVECALLBACK callback, std::vector<void *> arg_list)
+void CLCL::Impl::SetStopFunc(Callback callback)
 {
-	p_HMD->SetStopFunction(callback, arg_list);
+	p_HMD->SetStopFunction(std::move(callback));
 }
 
-void CLCL::Impl::SetDrawFunc(CAVECALLBACK callback, std::vector<void *> arg_list)
+void CLCL::Impl::SetDrawFunc(Callback callback)
 {
-	p_HMD->SetDrawFunction(callback, arg_list);
+	p_HMD->SetDrawFunction(std::move(callback));
 }
 
-void CLCL::Impl::SetIdleFunc(CAVECALLBACK callback, std::vector<void *> arg_list)
+void CLCL::Impl::SetIdleFunc(Callback callback)
 {
-	p_HMD->SetIdleFunction(callback, arg_list);
+	p_HMD->SetIdleFunction(std::move(callback));
 }
@@ -0,0 +1,229 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// loader.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "loader.h"
+#include "../thread/scheduling.h"
+
+ResourceLoader::ResourceLoader()
+{
+	m_Window = nullptr;
+	m_NextHandle = 0;
+	m_HLoader = nullptr;
+	m_IsThreadRunning.store(false);
+	for (int i = 0; i < MAX_UPLOAD_JOBS; i++)
+	{
+		m_Job[i].Handle.store(-1);
+		m_Job[i].State.store(UPLOAD_FREE);
+		m_Job[i].m_Fence = 0;
+	}
+}
+
+ResourceLoader::~ResourceLoader()
+{
+}
+
+bool ResourceLoader::Init(GLFWwindow* shareWindow)
+{
+	// hidden window which only provides a context shared with the render context
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+	m_Window = glfwCreateWindow(1, 1, "CLCL(loader)", NULL, shareWindow);
+	glfwWindowHint(GLFW_VISIBLE, GL_TRUE);
+	if (!m_Window)
+	{
+		std::cout << "ResourceLoader: DISABLE (uploads run on the display thread)" << std::endl;
+		return false;
+	}
+
+	m_IsThreadRunning.store(true);
+	m_HLoader = (HANDLE)_beginthreadex(0, 0, LoaderThreadLauncher, reinterpret_cast<void*>(this), 0, 0);
+	std::cout << "ResourceLoader: ENABLE" << std::endl;
+	return true;
+}
+
+void ResourceLoader::Terminate()
+{
+	if (m_HLoader != nullptr)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_QueueMutex);
+			m_IsThreadRunning.store(false);
+		}
+		m_QueueCondition.notify_all();
+		WaitForSingleObject(m_HLoader, INFINITE);
+		CloseHandle(m_HLoader);
+		m_HLoader = nullptr;
+	}
+	if (m_Window != nullptr)
+	{
+		glfwDestroyWindow(m_Window);
+		m_Window = nullptr;
+	}
+}
+
+int ResourceLoader::Enqueue(std::function<void()> function)
+{
+	std::lock_guard<std::mutex> lock(m_QueueMutex);
+	int handle = m_NextHandle;
+	UploadJob& job = m_Job[handle % MAX_UPLOAD_JOBS];
+	int state = job.State.load();
+	if ((state == UPLOAD_QUEUED) || (state == UPLOAD_FENCED))
+	{
+		std::cout << "WARNING: too many uploads in flight." << std::endl;
+		return -1;
+	}
+	m_NextHandle = (m_NextHandle + 1) & 0x7fffffff;
+
+	job.m_Function = function;
+	job.Handle.store(handle);
+	job.State.store(UPLOAD_QUEUED);
+	m_Queue.push_back(handle);
+	m_QueueCondition.notify_one();
+	return handle;
+}
+
+bool ResourceLoader::IsDone(int handle)
+{
+	if (handle < 0)
+	{
+		return true;
+	}
+
+	UploadJob& job = m_Job[handle % MAX_UPLOAD_JOBS];
+	if (job.Handle.load() != handle)
+	{
+		return true; // the slot has been reused, so the job finished long ago
+	}
+	int state = job.State.load();
+	return ((state == UPLOAD_DONE) || (state == UPLOAD_FREE));
+}
+
+void ResourceLoader::Wait(int handle)
+{
+	std::unique_lock<std::mutex> lock(m_DoneMutex);
+	m_DoneCondition.wait(lock, [this, handle]() { return IsDone(handle); });
+}
+
+void ResourceLoader::MarkDone(UploadJob& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_DoneMutex); // no wake-up is lost
+		job.State.store(UPLOAD_DONE);
+	}
+	m_DoneCondition.notify_all();
+}
+
+bool ResourceLoader::Dequeue(int& handle)
+{
+	std::lock_guard<std::mutex> lock(m_QueueMutex);
+	if (m_Queue.empty())
+	{
+		return false;
+	}
+	handle = m_Queue.front();
+	m_Queue.pop_front();
+	return true;
+}
+
+void ResourceLoader::Execute(int handle, std::vector<int>& fenced)
+{
+	UploadJob& job = m_Job[handle % MAX_UPLOAD_JOBS];
+	if (job.m_Function)
+	{
+		job.m_Function();
+	}
+	job.m_Function = nullptr;
+
+	job.m_Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush(); // the fence must reach the GPU before other contexts can see it
+	job.State.store(UPLOAD_FENCED);
+	fenced.push_back(handle);
+}
+
+void ResourceLoader::RetireFences(std::vector<int>& fenced)
+{
+	for (auto it = fenced.begin(); it != fenced.end(); )
+	{
+		UploadJob& job = m_Job[*it % MAX_UPLOAD_JOBS];
+		GLenum result = glClientWaitSync(job.m_Fence, 0, 0);
+		if ((result == GL_ALREADY_SIGNALED) ||
+			(result == GL_CONDITION_SATISFIED) ||
+			(result == GL_WAIT_FAILED))
+		{
+			glDeleteSync(job.m_Fence);
+			job.m_Fence = 0;
+			MarkDone(job);
+			it = fenced.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void ResourceLoader::ExecuteOnCurrentContext()
+{
+	std::vector<int> fenced;
+	int handle;
+	while (Dequeue(handle))
+	{
+		Execute(handle, fenced);
+	}
+	RetireFences(fenced);
+	for (size_t i = 0; i < fenced.size(); i++)
+	{
+		// the next frame is far away, so wait here instead of keeping the fence
+		UploadJob& job = m_Job[fenced[i] % MAX_UPLOAD_JOBS];
+		glClientWaitSync(job.m_Fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(job.m_Fence);
+		job.m_Fence = 0;
+		MarkDone(job);
+	}
+}
+
+void ResourceLoader::LoaderThread()
+{
+	ThreadScheduling::Apply(THREAD_LOADER);
+	glfwMakeContextCurrent(m_Window);
+
+	std::vector<int> fenced; // jobs waiting for the GPU
+	while (m_IsThreadRunning.load())
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_QueueMutex);
+			auto isReady = [this] { return !m_Queue.empty() || !m_IsThreadRunning.load(); };
+			if (fenced.empty())
+			{
+				m_QueueCondition.wait(lock, isReady);
+			}
+			else
+			{
+				// poll outstanding fences about once per millisecond
+				m_QueueCondition.wait_for(lock, std::chrono::milliseconds(1), isReady);
+			}
+		}
+
+		int handle;
+		if (m_IsThreadRunning.load() && Dequeue(handle))
+		{
+			Execute(handle, fenced);
+		}
+		RetireFences(fenced);
+	}
+
+	for (size_t i = 0; i < fenced.size(); i++)
+	{
+		glDeleteSync(m_Job[fenced[i] % MAX_UPLOAD_JOBS].m_Fence);
+	}
+	glfwMakeContextCurrent(NULL);
+}
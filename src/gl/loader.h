@@ -0,0 +1,96 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// loader.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "../settings.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX // to use "std::max()"
+#include <windows.h>
+#endif // _WIN32
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <process.h>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+// number of upload requests which can be in flight at the same time
+const int MAX_UPLOAD_JOBS = 256;
+
+// ResourceLoader owns a hidden window whose GL context is shared with the
+// render context. Jobs run on the loader thread; a fence is inserted after
+// each job so that the display thread can tell when the GPU copy is done.
+// Only textures, buffers, shaders and programs are shared between contexts;
+// container objects (VAO, FBO) must be created on the display thread.
+class ResourceLoader
+{
+	typedef enum {
+		UPLOAD_FREE = 0,
+		UPLOAD_QUEUED,
+		UPLOAD_FENCED,  // job executed, waiting for the GPU
+		UPLOAD_DONE
+	} UploadState;
+
+	struct UploadJob {
+		std::atomic<int>      Handle;
+		std::atomic<int>      State;
+		std::function<void()> m_Function;
+		GLsync                m_Fence;
+	};
+
+	GLFWwindow*             m_Window;
+	UploadJob               m_Job[MAX_UPLOAD_JOBS];
+	std::deque<int>         m_Queue;
+	std::mutex              m_QueueMutex;
+	std::condition_variable m_QueueCondition;
+	std::mutex              m_DoneMutex;
+	std::condition_variable m_DoneCondition; // a job became UPLOAD_DONE
+	int                     m_NextHandle;
+	HANDLE                  m_HLoader;
+	std::atomic<bool>       m_IsThreadRunning;
+
+	static unsigned __stdcall LoaderThreadLauncher(void *obj)
+	{
+		reinterpret_cast<ResourceLoader*>(obj)->LoaderThread();
+		_endthreadex(0);
+		return 0;
+	}
+	void   LoaderThread();
+	bool   Dequeue(int& handle);
+	void   Execute(int handle, std::vector<int>& fenced);
+	void   RetireFences(std::vector<int>& fenced);
+	void   MarkDone(UploadJob& job);
+
+public:
+	ResourceLoader();
+	~ResourceLoader();
+
+	bool   Init(GLFWwindow* shareWindow);
+	void   Terminate();
+	bool   IsRunning() { return m_IsThreadRunning.load(); }
+
+	int    Enqueue(std::function<void()> function);
+	bool   IsDone(int handle);
+	void   Wait(int handle);
+	void   ExecuteOnCurrentContext(); // fallback when the shared context is unavailable
+};
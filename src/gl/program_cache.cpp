@@ -0,0 +1,350 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// program_cache.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "program_cache.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX // to use "std::max()"
+#include <windows.h>
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	const uint PROGRAM_CACHE_MAGIC   = 0x42504c43; // "CLPB"
+	const uint PROGRAM_CACHE_VERSION = 2;
+
+	// FNV offset basis for the file name, and a second seed for the check
+	const unsigned long long KEY_SEED   = 0xcbf29ce484222325ULL;
+	const unsigned long long CHECK_SEED = 0x84222325cbf29ce4ULL;
+
+	struct ProgramCacheHeader {
+		uint   Magic;
+		uint   Version;
+		unsigned long long Key;   // hash of the sources and the driver (the file name)
+		unsigned long long Check; // the same with another seed, against collisions
+		GLenum Format;         // binary format returned by glGetProgramBinary
+		GLint  Length;
+		double CompileSeconds; // time spent to build the program from source
+	};
+
+	// 64-bit FNV-1a
+	unsigned long long HashString(unsigned long long hash, const char* str)
+	{
+		if (str == nullptr)
+		{
+			str = "";
+		}
+		for (const uchar* p = reinterpret_cast<const uchar*>(str); ; p++)
+		{
+			hash ^= *p;
+			hash *= 0x100000001b3ULL;
+			if (*p == '\0') break; // the terminator separates the strings
+		}
+		return hash;
+	}
+
+	double Now()
+	{
+		return std::chrono::duration<double>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	bool CompileShader(GLuint& shaderID, GLenum type, const char* src)
+	{
+		shaderID = glCreateShader(type);
+		glShaderSource(shaderID, 1, &src, 0);
+		glCompileShader(shaderID);
+
+		GLint status = GL_FALSE;
+		glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
+		if (status != GL_TRUE)
+		{
+			GLint length = 0;
+			glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &length);
+			std::vector<char> log(length + 1, '\0');
+			glGetShaderInfoLog(shaderID, length, &length, log.data());
+			std::cout << "ERROR: while compiling Shader :" << std::endl << log.data() << std::endl;
+			glDeleteShader(shaderID);
+			shaderID = 0;
+			return false;
+		}
+		return true;
+	}
+}
+
+ProgramCache::ProgramCache()
+{
+	const char* directory = getenv("CLCL_SHADER_CACHE");
+	m_Directory = (directory != nullptr) ? directory : CLCL_SHADER_CACHE_DIR;
+	m_IsAvailable = false;
+	m_IsChecked = false;
+	m_Hits = 0;
+	m_Misses = 0;
+	m_SavedSeconds = 0.0;
+}
+
+ProgramCache& ProgramCache::Instance()
+{
+	static ProgramCache instance;
+	return instance;
+}
+
+void ProgramCache::SetDirectory(const char* directory)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Directory = directory;
+}
+
+void ProgramCache::CheckDriver()
+{
+	// must be called with a current GL context
+	if (m_IsChecked)
+	{
+		return;
+	}
+	m_IsChecked = true;
+
+	GLint numFormats = 0;
+	if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+	{
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+	}
+	m_IsAvailable = (numFormats > 0);
+
+	const char* vendor   = reinterpret_cast<const char*>(glGetString(GL_VENDOR));
+	const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+	const char* version  = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+	m_DriverID  = (vendor   != nullptr) ? vendor   : "";
+	m_DriverID += "|";
+	m_DriverID += (renderer != nullptr) ? renderer : "";
+	m_DriverID += "|";
+	m_DriverID += (version  != nullptr) ? version  : "";
+
+	if (m_IsAvailable)
+	{
+#ifdef _WIN32
+		_mkdir(m_Directory.c_str());
+#else
+		mkdir(m_Directory.c_str(), 0755);
+#endif
+	}
+	else
+	{
+		std::cout << "ProgramCache: DISABLE (no program binary format)" << std::endl;
+	}
+}
+
+unsigned long long ProgramCache::Key(const char* vs, const char* fs, const char* bindings, unsigned long long seed)
+{
+	unsigned long long key = HashString(seed, vs);
+	key = HashString(key, fs);
+	key = HashString(key, bindings);
+	return HashString(key, m_DriverID.c_str());
+}
+
+std::string ProgramCache::FileName(unsigned long long key)
+{
+	char name[32];
+	sprintf(name, "%016llx.bin", key);
+	return m_Directory + "/" + name;
+}
+
+GLuint ProgramCache::Load(const char* vs, const char* fs, const char* bindings)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	CheckDriver();
+	if (!m_IsAvailable)
+	{
+		return 0;
+	}
+
+	double start = Now();
+	unsigned long long key = Key(vs, fs, bindings, KEY_SEED);
+	std::string fileName = FileName(key);
+	FILE *fp = fopen(fileName.c_str(), "rb");
+	if (fp == nullptr)
+	{
+		return 0;
+	}
+
+	ProgramCacheHeader header;
+	std::vector<char> binary;
+	bool isValid = (fread(&header, sizeof(header), 1, fp) == 1) &&
+		(header.Magic == PROGRAM_CACHE_MAGIC) &&
+		(header.Version == PROGRAM_CACHE_VERSION) &&
+		(header.Key == key) &&
+		(header.Check == Key(vs, fs, bindings, CHECK_SEED)) &&
+		(header.Length > 0);
+	if (isValid)
+	{
+		binary.resize(header.Length);
+		isValid = (fread(binary.data(), 1, header.Length, fp) == static_cast<size_t>(header.Length));
+	}
+	fclose(fp);
+	if (!isValid)
+	{
+		return 0;
+	}
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.Format, binary.data(), header.Length);
+	GLint status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		// the driver was updated or the binary is broken; rebuild from source
+		glDeleteProgram(program);
+		remove(fileName.c_str());
+		return 0;
+	}
+
+	m_Hits++;
+	m_SavedSeconds += header.CompileSeconds - (Now() - start);
+	return program;
+}
+
+void ProgramCache::Store(GLuint program, const char* vs, const char* fs, const char* bindings, double compileSeconds)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	CheckDriver();
+	if (!m_IsAvailable || (program == 0))
+	{
+		return;
+	}
+
+	ProgramCacheHeader header;
+	header.Magic = PROGRAM_CACHE_MAGIC;
+	header.Version = PROGRAM_CACHE_VERSION;
+	header.Key = Key(vs, fs, bindings, KEY_SEED);
+	header.Check = Key(vs, fs, bindings, CHECK_SEED);
+	header.Format = 0;
+	header.Length = 0;
+	header.CompileSeconds = compileSeconds;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &header.Length);
+	if (header.Length <= 0)
+	{
+		return;
+	}
+
+	std::vector<char> binary(header.Length);
+	glGetProgramBinary(program, header.Length, &header.Length, &header.Format, binary.data());
+	if (header.Length <= 0)
+	{
+		return;
+	}
+
+	// written to a temporary file and renamed, so that a crash never leaves
+	// a truncated binary under the real name
+	std::string fileName = FileName(header.Key);
+	std::string temporaryName = fileName + ".tmp";
+	FILE *fp = fopen(temporaryName.c_str(), "wb");
+	if (fp == nullptr)
+	{
+		std::cout << "ProgramCache: could not write " << fileName << std::endl;
+		return;
+	}
+	bool isWritten = (fwrite(&header, sizeof(header), 1, fp) == 1) &&
+		(fwrite(binary.data(), 1, header.Length, fp) == static_cast<size_t>(header.Length));
+	isWritten = (fclose(fp) == 0) && isWritten;
+#ifdef _WIN32
+	isWritten = isWritten && MoveFileExA(temporaryName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+	isWritten = isWritten && (rename(temporaryName.c_str(), fileName.c_str()) == 0);
+#endif
+	if (!isWritten)
+	{
+		std::cout << "ProgramCache: could not write " << fileName << std::endl;
+		remove(temporaryName.c_str());
+	}
+}
+
+GLuint ProgramCache::CreateProgram(const char* vs, const char* fs)
+{
+	GLuint program = Load(vs, fs, "");
+	if (program != 0)
+	{
+		return program;
+	}
+	CountMiss();
+
+	double start = Now();
+	GLuint vertexID, fragmentID;
+	if (!CompileShader(vertexID, GL_VERTEX_SHADER, vs))
+	{
+		return 0;
+	}
+	if (!CompileShader(fragmentID, GL_FRAGMENT_SHADER, fs))
+	{
+		glDeleteShader(vertexID);
+		return 0;
+	}
+
+	program = glCreateProgram();
+	glAttachShader(program, vertexID);
+	glAttachShader(program, fragmentID);
+	if (IsAvailable())
+	{
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	glLinkProgram(program);
+	glDetachShader(program, vertexID);
+	glDetachShader(program, fragmentID);
+	glDeleteShader(vertexID);
+	glDeleteShader(fragmentID);
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		GLint length = 0;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+		std::vector<char> log(length + 1, '\0');
+		glGetProgramInfoLog(program, length, &length, log.data());
+		std::cout << "ERROR: while linking Shader :" << std::endl << log.data() << std::endl;
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	Store(program, vs, fs, "", Now() - start);
+	return program;
+}
+
+void ProgramCache::GetStats(int *hits, int *misses, double *savedSeconds)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (hits != nullptr) *hits = m_Hits;
+	if (misses != nullptr) *misses = m_Misses;
+	if (savedSeconds != nullptr) *savedSeconds = m_SavedSeconds;
+}
+
+void ProgramCache::Report()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if ((m_Hits == 0) && (m_Misses == 0))
+	{
+		return;
+	}
+	std::cout << "ProgramCache: hits " << m_Hits << ", misses " << m_Misses
+		<< ", time saved " << m_SavedSeconds * 1000.0 << " ms" << std::endl;
+}
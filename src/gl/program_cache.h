@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// program_cache.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "../settings.h"
+
+#include <string>
+#include <mutex>
+#include <atomic>
+
+#include <GL/glew.h>
+
+// default directory of the program-binary cache
+// (can be overridden by the environment variable "CLCL_SHADER_CACHE")
+#define CLCL_SHADER_CACHE_DIR "shader_cache"
+
+// ProgramCache stores linked program binaries (glGetProgramBinary) keyed on
+// a hash of the shader sources and the driver vendor, renderer and version.
+// A binary which the driver rejects is treated as a miss and recompiled.
+class ProgramCache
+{
+	std::mutex  m_Mutex;
+	std::string m_Directory;
+	std::string m_DriverID;    // vendor, renderer and version of the GL driver
+	std::atomic<bool> m_IsAvailable; // false if the driver has no binary formats
+	bool        m_IsChecked;
+	int         m_Hits;
+	int         m_Misses;
+	double      m_SavedSeconds;
+
+	ProgramCache();
+	void        CheckDriver();
+	unsigned long long Key(const char* vs, const char* fs, const char* bindings, unsigned long long seed);
+	std::string FileName(unsigned long long key);
+
+public:
+	static ProgramCache& Instance();
+
+	void   SetDirectory(const char* directory);
+
+	// Returns a linked program, or 0 if the cache has no usable binary.
+	GLuint Load(const char* vs, const char* fs, const char* bindings);
+	void   Store(GLuint program, const char* vs, const char* fs, const char* bindings, double compileSeconds);
+	void   CountMiss() { std::lock_guard<std::mutex> lock(m_Mutex); m_Misses++; }
+	bool   IsAvailable() const { return m_IsAvailable.load(); }
+
+	// Compiles and links a program from source through the cache.
+	GLuint CreateProgram(const char* vs, const char* fs);
+
+	void   GetStats(int *hits, int *misses, double *savedSeconds);
+	void   Report();
+};
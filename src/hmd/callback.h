@@ -0,0 +1,280 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// callback.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+
+// callables up to this size are stored without heap allocation
+// (large enough for std::function and for a function with 7 pointer arguments)
+const size_t CALLBACK_BUFFER_SIZE = 64;
+const int    CALLBACK_MAX_ARGS = 16;
+
+// Callback is a type-erased "void()" callable built once at registration.
+//
+// It holds a lambda, a std::function, a function pointer bound to typed
+// arguments (Bind()) or a CAVELib style function with "void*" arguments.
+// Callables of up to CALLBACK_BUFFER_SIZE bytes are stored inline, so calling
+// and copying them do not allocate.
+class Callback
+{
+public:
+	typedef void(*Function)();
+
+	Callback() : p_Invoke(nullptr), p_Manage(nullptr) {}
+
+	template <class F, class = typename std::enable_if<!std::is_same<typename std::decay<F>::type, Callback>::value>::type>
+	Callback(F&& function) : p_Invoke(nullptr), p_Manage(nullptr)
+	{
+		Store(std::forward<F>(function));
+	}
+
+	// CAVELib varargs form: function(args[0], ..., args[count - 1])
+	Callback(Function function, void* const *args, int count) : p_Invoke(nullptr), p_Manage(nullptr)
+	{
+		if (function == nullptr)
+		{
+			return;
+		}
+		if ((count < 0) || (count > CALLBACK_MAX_ARGS))
+		{
+			std::cout << "CLCL: Callbacks take at most " << CALLBACK_MAX_ARGS << " arguments." << std::endl;
+			return;
+		}
+		StoreVarargs(function, args, count, std::integral_constant<int, 0>());
+	}
+
+	// function(args...) with typed arguments copied at registration
+	template <class... P, class... A>
+	static Callback Bind(void(*function)(P...), A&&... args)
+	{
+		return Callback(BoundCall<void(*)(P...), typename std::decay<A>::type...>(function, std::forward<A>(args)...));
+	}
+
+	Callback(const Callback& other) : p_Invoke(nullptr), p_Manage(nullptr)
+	{
+		if (other.p_Manage != nullptr)
+		{
+			other.p_Manage(COPY, this, const_cast<Callback*>(&other));
+		}
+	}
+	Callback(Callback&& other) : p_Invoke(nullptr), p_Manage(nullptr)
+	{
+		if (other.p_Manage != nullptr)
+		{
+			other.p_Manage(MOVE, this, &other);
+		}
+	}
+	Callback& operator=(const Callback& other)
+	{
+		if (this != &other)
+		{
+			Callback copy(other);
+			Reset();
+			*this = std::move(copy);
+		}
+		return *this;
+	}
+	Callback& operator=(Callback&& other)
+	{
+		if (this != &other)
+		{
+			Reset();
+			if (other.p_Manage != nullptr)
+			{
+				other.p_Manage(MOVE, this, &other);
+			}
+		}
+		return *this;
+	}
+	~Callback() { Reset(); }
+
+	void Reset()
+	{
+		if (p_Manage != nullptr)
+		{
+			p_Manage(DESTROY, this, nullptr);
+		}
+		p_Invoke = nullptr;
+		p_Manage = nullptr;
+	}
+
+	void operator()() const
+	{
+		if (p_Invoke != nullptr)
+		{
+			p_Invoke(const_cast<void*>(static_cast<const void*>(&m_Buffer)));
+		}
+	}
+	explicit operator bool() const { return p_Invoke != nullptr; }
+
+private:
+	enum Operation { COPY, MOVE, DESTROY };
+
+	typedef typename std::aligned_storage<CALLBACK_BUFFER_SIZE, alignof(void*)>::type Buffer;
+
+	void (*p_Invoke)(void *buffer);
+	void (*p_Manage)(Operation operation, Callback *to, Callback *from);
+	Buffer m_Buffer;
+
+	template <class F>
+	struct IsInline
+	{
+		static const bool value = (sizeof(F) <= sizeof(Buffer)) && (alignof(Buffer) % alignof(F) == 0)
+			&& std::is_nothrow_move_constructible<F>::value;
+	};
+
+	// the callable itself is stored in the buffer
+	template <class F>
+	struct InlineTarget
+	{
+		static F* Get(void *buffer) { return static_cast<F*>(buffer); }
+		static void Invoke(void *buffer) { (*Get(buffer))(); }
+		static void Manage(Operation operation, Callback *to, Callback *from)
+		{
+			switch (operation)
+			{
+				case COPY:
+					new (&to->m_Buffer) F(*Get(&from->m_Buffer));
+					to->p_Invoke = from->p_Invoke;
+					to->p_Manage = from->p_Manage;
+					break;
+				case MOVE:
+					new (&to->m_Buffer) F(std::move(*Get(&from->m_Buffer)));
+					to->p_Invoke = from->p_Invoke;
+					to->p_Manage = from->p_Manage;
+					from->Reset();
+					break;
+				case DESTROY:
+					Get(&to->m_Buffer)->~F();
+					break;
+			}
+		}
+	};
+
+	// larger callables are allocated once and the buffer holds the pointer
+	template <class F>
+	struct HeapTarget
+	{
+		static F*& Get(void *buffer) { return *static_cast<F**>(buffer); }
+		static void Invoke(void *buffer) { (*Get(buffer))(); }
+		static void Manage(Operation operation, Callback *to, Callback *from)
+		{
+			switch (operation)
+			{
+				case COPY:
+					new (&to->m_Buffer) F*(new F(*Get(&from->m_Buffer)));
+					to->p_Invoke = from->p_Invoke;
+					to->p_Manage = from->p_Manage;
+					break;
+				case MOVE:
+					new (&to->m_Buffer) F*(Get(&from->m_Buffer));
+					to->p_Invoke = from->p_Invoke;
+					to->p_Manage = from->p_Manage;
+					from->p_Invoke = nullptr;
+					from->p_Manage = nullptr;
+					break;
+				case DESTROY:
+					delete Get(&to->m_Buffer);
+					break;
+			}
+		}
+	};
+
+	template <class F>
+	void Store(F&& function)
+	{
+		typedef typename std::decay<F>::type Target;
+		if (!IsValid(function))
+		{
+			return;
+		}
+		StoreTarget<Target>(std::forward<F>(function), std::integral_constant<bool, IsInline<Target>::value>());
+	}
+
+	template <class Target, class F>
+	void StoreTarget(F&& function, std::true_type)
+	{
+		new (&m_Buffer) Target(std::forward<F>(function));
+		p_Invoke = &InlineTarget<Target>::Invoke;
+		p_Manage = &InlineTarget<Target>::Manage;
+	}
+
+	template <class Target, class F>
+	void StoreTarget(F&& function, std::false_type)
+	{
+		new (&m_Buffer) Target*(new Target(std::forward<F>(function)));
+		p_Invoke = &HeapTarget<Target>::Invoke;
+		p_Manage = &HeapTarget<Target>::Manage;
+	}
+
+	// empty function pointers and std::function are stored as "no callback"
+	template <class F>
+	static auto IsValid(const F& function, int) -> decltype(static_cast<bool>(function)) { return static_cast<bool>(function); }
+	template <class F>
+	static bool IsValid(const F&, long) { return true; }
+	template <class F>
+	static bool IsValid(const F& function) { return IsValid(function, 0); }
+
+	template <class F, class... A>
+	struct BoundCall
+	{
+		template <class... T>
+		BoundCall(F function, T&&... args) : p_Function(function), m_Args(std::forward<T>(args)...) {}
+		void operator()() { Call(std::index_sequence_for<A...>()); }
+		template <size_t... I>
+		void Call(std::index_sequence<I...>) { p_Function(std::get<I>(m_Args)...); }
+
+		F p_Function;
+		std::tuple<A...> m_Args;
+	};
+
+	template <size_t>
+	using VoidPtr = void*;
+
+	template <int N>
+	struct VarargsCall
+	{
+		VarargsCall(Function function, void* const *args) : p_Function(function)
+		{
+			for (int i = 0; i < N; i++)
+			{
+				m_Args[i] = args[i];
+			}
+		}
+		void operator()() const { Call(std::make_index_sequence<N>()); }
+		template <size_t... I>
+		void Call(std::index_sequence<I...>) const { reinterpret_cast<void(*)(VoidPtr<I>...)>(p_Function)(m_Args[I]...); }
+
+		Function p_Function;
+		void* m_Args[N > 0 ? N : 1];
+	};
+
+	// finds the arity given at run time among 0 ... CALLBACK_MAX_ARGS
+	template <int N>
+	void StoreVarargs(Function function, void* const *args, int count, std::integral_constant<int, N>)
+	{
+		if (count == N)
+		{
+			Store(VarargsCall<N>(function, args));
+			return;
+		}
+		StoreVarargs(function, args, count, std::integral_constant<int, N + 1>());
+	}
+	void StoreVarargs(Function, void* const*, int, std::integral_constant<int, CALLBACK_MAX_ARGS + 1>) {}
+};
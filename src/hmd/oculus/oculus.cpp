@@ -13,6 +13,85 @@
 
 #include "oculus.h"
 
+static OVR::Matrix4f ToMatrix4f(const Affine& a)
+{
+	OVR::Matrix4f m;
+	AffineToMatrix(a, m.M);
+	return m;
+}
+
+// rotation of a navigated pose, without the scaling of the navigation
+static OVR::Quatf RotationOf(const OVR::Matrix4f& m)
+{
+	OVR::Matrix4f rotation;
+	for (int j = 0; j < 3; j++)
+	{
+		float length = sqrtf(m.M[0][j] * m.M[0][j] + m.M[1][j] * m.M[1][j] + m.M[2][j] * m.M[2][j]);
+		for (int i = 0; i < 3; i++)
+		{
+			rotation.M[i][j] = (length > 0.0f) ? m.M[i][j] / length : 0.0f;
+		}
+	}
+	return OVR::Quatf(rotation);
+}
+
+static void StorePose(const OVR::Vector3f& position, const OVR::Quatf& orientation, Pose& pose)
+{
+	pose.Position[0] = position.x;
+	pose.Position[1] = position.y;
+	pose.Position[2] = position.z;
+	pose.Orientation[0] = orientation.x;
+	pose.Orientation[1] = orientation.y;
+	pose.Orientation[2] = orientation.z;
+	pose.Orientation[3] = orientation.w;
+}
+
+// a tracked pose in CAVE (or navigated) coordinates
+static void ToCAVEPose(const ovrPosef& trackedPose, const OVR::Matrix4f& navigationInverse, bool navigated, Pose& pose)
+{
+	OVR::Vector3f position = OVR::Vector3f(trackedPose.Position) * (10.0f / FEET_PER_METER);
+	if (!navigated)
+	{
+		StorePose(position, trackedPose.Orientation, pose);
+		return;
+	}
+	OVR::Matrix4f matrix = OVR::Matrix4f(OVR::Quatf(trackedPose.Orientation));
+	matrix.SetTranslation(position);
+	matrix = navigationInverse * matrix;
+	StorePose(matrix.GetTranslation(), RotationOf(matrix), pose);
+}
+
+// physical and navigated state of a tracked pose
+static void StoreSensor(const ovrPosef& trackedPose, const OVR::Matrix4f& navigationInverse, SensorState sensor[2])
+{
+	static const float front[3] = { 0.0f, 0.0f, -1.0f };
+	static const float up[3]    = { 0.0f, 1.0f,  0.0f };
+	static const float right[3] = { 1.0f, 0.0f,  0.0f };
+	for (int i = 0; i < 2; i++)
+	{
+		Pose pose;
+		ToCAVEPose(trackedPose, navigationInverse, (i == 1), pose);
+		SensorState& state = sensor[i];
+		memcpy(state.Position, pose.Position, sizeof(state.Position));
+		memcpy(state.Orientation, pose.Orientation, sizeof(state.Orientation));
+		OVR::Quatf orientation(pose.Orientation[0], pose.Orientation[1], pose.Orientation[2], pose.Orientation[3]);
+		orientation.GetEulerAngles<OVR::Axis_Y, OVR::Axis_X, OVR::Axis_Z, OVR::Rotate_CCW, OVR::Handed_R>(&state.Angle[0], &state.Angle[1], &state.Angle[2]);
+		RotateVector(pose.Orientation, front, state.Front);
+		RotateVector(pose.Orientation, up, state.Up);
+		RotateVector(pose.Orientation, right, state.Right);
+	}
+}
+
+#if (OVR_PRODUCT_VERSION == 1)
+// estimated GPU memory of an RGBA8 swap chain
+static long long SwapChainBytes(ovrSession session, ovrTextureSwapChain swapChain, int width, int height)
+{
+	int length = 0;
+	ovr_GetTextureSwapChainLength(session, swapChain, &length);
+	return MemoryStats::ImageBytes(width, height, 4, length);
+}
+#endif
+
 #define FULL_SCREEN_MODE
 
 bool m_InitializedGLFW = false;
@@ -47,14 +126,16 @@ Oculus::Oculus()
 	m_SnapNo = 0;
 
 	m_CurrentEyeIndex = ovrEyeType::ovrEye_Left;
-	m_NavigationMatrix.SetIdentity();
+	m_Navigation.SetIdentity();
+	m_LatchedNavigation[0] = m_Navigation.transform();
+	m_LatchedNavigation[1] = m_Navigation.inverse();
 	m_ModelMatrix.SetIdentity();
 
 #if (OVR_PRODUCT_VERSION == 1)
 	m_TextureSwapChain = 0; // for Oculus SDK 1.10.1
 	m_MirrorFBO = 0;        // for Oculus SDK 1.10.1
 
-	m_CurrentControllerType = MOUSE;
+	m_CurrentControllerType.store(MOUSE);
 	m_IsConnected[0] = true; // mouse
 	for (int i = 1; i < ENUM_CONTROLLER_TYPE_SIZE; i++)
 	{
@@ -69,16 +150,37 @@ Oculus::Oculus()
 
 	m_IsThreadRunning = true;
 	m_IsInitializedGLFW.store(false);
+	m_IsInitFailed = false;
 	m_HMutex = nullptr;
 	m_HRender = nullptr;
-	p_InitFunction = nullptr;
-	p_StopFunction = nullptr;
-	p_DrawFunction = nullptr;
-	p_IdleFunction = nullptr;
 	m_MainThreadID = 0;
 	m_DisplayThreadID = 0;
+	m_HTracker = nullptr;
+	m_TrackerThreadID.store(0);
+	m_IsTrackerRunning.store(false);
+	m_TrackerRate.store(0);
 
 	m_IsInitFunctionExecuted = false;
+	for (int i = 0; i < CALLBACK_TYPE_COUNT; i++)
+	{
+		m_IsCallbackPending[i] = false;
+	}
+	m_HasPendingCallback.store(false);
+
+	for (int i = 0; i < MAX_QUAD_LAYERS; i++)
+	{
+		m_QuadLayer[i].State.store(QUAD_LAYER_FREE);
+		m_QuadLayer[i].IsDirty.store(false);
+		m_QuadLayer[i].HasContent = false;
+		m_QuadLayer[i].m_Function.Reset();
+#if (OVR_PRODUCT_VERSION == 1)
+		m_QuadLayer[i].m_SwapChain = 0;
+#endif
+	}
+	m_QuadLayerFBO = 0;
+	m_RenderTargetBytes = 0;
+	memset(m_Frustum, 0, sizeof(m_Frustum)); // all objects are visible until the first frame
+	memset(&m_SensorFrame, 0, sizeof(m_SensorFrame));
 
 	m_FPS = new float;
 }
@@ -88,7 +190,7 @@ Oculus::~Oculus()
 	delete m_FPS;
 }
 
-void Oculus::Init()
+bool Oculus::Init()
 {
 	// initialization of oculus
 #if (OVR_PRODUCT_VERSION == 1)
@@ -96,7 +198,7 @@ void Oculus::Init()
 	if (OVR_FAILURE(result))
 	{
 		std::cout << "HMD Initialization : FAILED\n";
-		exit(EXIT_FAILURE);
+		return false;
 	}
 
 	ovrGraphicsLuid luid;
@@ -104,8 +206,9 @@ void Oculus::Init()
 	if (OVR_FAILURE(result))
 	{
 		std::cout << "HMD Initialization : FAILED2\n";
+		m_HmdSession = nullptr;
 		ovr_Shutdown();
-		exit(EXIT_FAILURE);
+		return false;
 	}
 
 	m_HmdDesc = ovr_GetHmdDesc(m_HmdSession);
@@ -148,15 +251,16 @@ void Oculus::Init()
 	ovrResult result = ovr_Initialize(nullptr);
 	if (OVR_FAILURE(result))
 	{
-		exit(EXIT_FAILURE);
+		return false;
 	}
 
 	ovrGraphicsLuid luid;
 	result = ovr_Create(&m_HmdSession, &luid);
 	if (OVR_FAILURE(result))
 	{
+		m_HmdSession = nullptr;
 		ovr_Shutdown();
-		exit(EXIT_FAILURE);
+		return false;
 	}
 
 	m_HmdDesc = ovr_GetHmdDesc(m_HmdSession);
@@ -166,7 +270,7 @@ void Oculus::Init()
 	ovrResult result = ovr_Initialize(nullptr);
 	if (OVR_FAILURE(result))
 	{
-		exit(EXIT_FAILURE);
+		return false;
 	}
 
 	result = ovrHmd_Create(0, &m_HmdSession);
@@ -207,16 +311,22 @@ void Oculus::Init()
 		ovrTrackingCap_Position, 0);
 #endif
 #endif
+	return true;
 }
 
-void Oculus::InitGL()
+bool Oculus::InitGLFW()
 {
 	glfwSetErrorCallback(this->ErrorCallback);
 	if (!glfwInit())
 	{
-		exit(EXIT_FAILURE);
+		std::cout << "CLCL: Failed to initialize GLFW." << std::endl;
+		return false;
 	}
+	return true;
+}
 
+void Oculus::InitGL()
+{
 #if (OVR_PRODUCT_VERSION == 1)
 	GLFWmonitor* monitor = glfwGetPrimaryMonitor();
 	int width, height;
@@ -293,6 +403,7 @@ void Oculus::InitGL()
 	if (m_WindowStyle != DIRECT_MODE)
 	{
 		m_MirrorRGBImage = new uchar[m_HmdSession->Resolution.w * m_HmdSession->Resolution.h * 3];
+		MemoryStats::Allocate(MEMORY_HOST_BUFFER, MemoryStats::ImageBytes(m_HmdSession->Resolution.w, m_HmdSession->Resolution.h, 3));
 		if (m_WindowStyle == EXTEND_MODE)
 		{
 			glfwWindowHint(GLFW_DECORATED, GL_TRUE);
@@ -328,13 +439,32 @@ void Oculus::InitGL()
 		exit(EXIT_FAILURE);
 	}
 
+	// second context shared with m_Window for background uploads
+	m_ResourceLoader.Init(m_Window);
+}
+
+bool Oculus::OpenCamera()
+{
+	bool isOpen = true;
 #ifdef USE_OVRVISION
-	m_OVRVision.Init();
+	isOpen = m_OVRVision.Open() && isOpen;
+#endif // USE_OVRVISION
+
+#ifdef USE_ZEDMINI
+	isOpen = m_ZedMini.Open() && isOpen;
+#endif // USE_ZEDMINI
+	return isOpen;
+}
+
+void Oculus::InitCamera()
+{
+#ifdef USE_OVRVISION
+	m_OVRVision.InitGL();
 //	m_OVRVision.toggleCameraState(); // change value from "false" to "true" (default: false)
 #endif // USE_OVRVISION
 
 #ifdef USE_ZEDMINI
-	if (m_ZedMini.Init())
+	if (m_ZedMini.InitGL())
 	{
 		std::cout << "initialization of zed mini succeeded." << std::endl;
 //		glfwMakeContextCurrent(m_Window);
@@ -450,6 +580,7 @@ void Oculus::CreateBuffers()
 		std::cout << "ERROR: Cound not get length of TextureSwapChain." << std::endl;
 		exit(EXIT_FAILURE);
 	}
+	m_RenderTargetBytes = MemoryStats::ImageBytes(m_RenderTargetSize.w, m_RenderTargetSize.h, 4, textureSwapChainLength);
 
 	for (int i = 0; i < textureSwapChainLength; ++i)
 	{
@@ -494,6 +625,7 @@ void Oculus::CreateBuffers()
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	}
 	glBindTexture(GL_TEXTURE_2D, 0);
+	m_RenderTargetBytes = MemoryStats::ImageBytes(m_RenderTargetSize.w, m_RenderTargetSize.h, 4, p_SwapTextureSet->TextureCount);
 	m_LayerEyeFov.ColorTexture[0] = p_SwapTextureSet;
 	m_LayerEyeFov.ColorTexture[1] = p_SwapTextureSet;
 	m_LayerEyeFov.Viewport[0] = OVR::Recti(0, 0, m_RenderTargetSize.w / 2, m_RenderTargetSize.h);
@@ -513,6 +645,7 @@ void Oculus::CreateBuffers()
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
 		m_RenderTargetSize.w, m_RenderTargetSize.h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 	glBindTexture(GL_TEXTURE_2D, 0);
+	m_RenderTargetBytes = MemoryStats::ImageBytes(m_RenderTargetSize.w, m_RenderTargetSize.h, 4);
 #endif
 #endif
 
@@ -525,6 +658,7 @@ void Oculus::CreateBuffers()
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_RenderTargetSize.w, m_RenderTargetSize.h);
 #endif
 	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	m_RenderTargetBytes += MemoryStats::ImageBytes(m_RenderTargetSize.w, m_RenderTargetSize.h, 4);
 
 	// create a framebuffer object and bind the depth buffer
 	glGenFramebuffers(1, &m_FrameBuffer);
@@ -553,6 +687,7 @@ void Oculus::CreateBuffers()
 		std::cout << "ERROR: Cound not create mirror texture." << std::endl;
 		exit(EXIT_FAILURE);
 	}
+	m_RenderTargetBytes += MemoryStats::ImageBytes(mirrorTextureDesc.Width, mirrorTextureDesc.Height, 4);
 	glGenFramebuffers(1, &m_MirrorFBO);
 #else
 #if (OVR_MAJOR_VERSION > 5)
@@ -563,6 +698,7 @@ void Oculus::CreateBuffers()
 #endif
 	if (OVR_SUCCESS(result))
 	{
+		m_RenderTargetBytes += MemoryStats::ImageBytes(m_WindowSize.w, m_WindowSize.h, 4);
 		glGenFramebuffers(1, &m_MirrorFBO);
 		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_MirrorFBO);
 		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mirrorTexture->OGL.TexId, 0);
@@ -588,6 +724,8 @@ void Oculus::CreateBuffers()
 #endif
 #endif
 
+	MemoryStats::Allocate(MEMORY_GPU_RENDER_TARGET, m_RenderTargetBytes);
+
 	// check buffers
 	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 	{
@@ -635,6 +773,7 @@ void Oculus::CreateBuffers()
 
 #ifdef STORE_LEFT_EYE_TEXTURE
 	m_LeftEyeTextureData = (uchar *)malloc(sizeof(uchar) * m_RenderTargetSize.w / 2 * m_RenderTargetSize.h * 3);
+	MemoryStats::Allocate(MEMORY_HOST_BUFFER, MemoryStats::ImageBytes(m_RenderTargetSize.w / 2, m_RenderTargetSize.h, 3));
 /*
 	glGenTextures(1, &m_LeftEyeTextureID);
 	glBindTexture(GL_TEXTURE_2D, m_LeftEyeTextureID);
@@ -652,6 +791,19 @@ void Oculus::Terminate()
 	if (m_HmdSession != nullptr)
 	{
 #if (OVR_PRODUCT_VERSION == 1)
+		for (int i = 0; i < MAX_QUAD_LAYERS; i++)
+		{
+			if (m_QuadLayer[i].m_SwapChain != 0)
+			{
+				MemoryStats::Free(MEMORY_GPU_QUAD_LAYER, SwapChainBytes(m_HmdSession, m_QuadLayer[i].m_SwapChain, m_QuadLayer[i].Width, m_QuadLayer[i].Height));
+				ovr_DestroyTextureSwapChain(m_HmdSession, m_QuadLayer[i].m_SwapChain);
+				m_QuadLayer[i].m_SwapChain = 0;
+			}
+		}
+		if (m_QuadLayerFBO != 0)
+		{
+			glDeleteFramebuffers(1, &m_QuadLayerFBO);
+		}
 		glDeleteFramebuffers(1, &m_FrameBuffer);
 		glDeleteRenderbuffers(1, &m_DepthBuffer);
 		glDeleteFramebuffers(1, &m_MirrorFBO);
@@ -677,21 +829,43 @@ void Oculus::Terminate()
 		glDeleteRenderbuffers(1, &m_DepthBuffer);
 #endif
 #endif
+		MemoryStats::Free(MEMORY_GPU_RENDER_TARGET, m_RenderTargetBytes);
+		m_RenderTargetBytes = 0;
 	}
 
+#ifdef STORE_LEFT_EYE_TEXTURE
+	free(m_LeftEyeTextureData);
+	m_LeftEyeTextureData = nullptr;
+	MemoryStats::Free(MEMORY_HOST_BUFFER, MemoryStats::ImageBytes(m_RenderTargetSize.w / 2, m_RenderTargetSize.h, 3));
+#endif // STORE_LEFT_EYE_TEXTURE
+
 #if ((OVR_PRODUCT_VERSION == 0) && (OVR_MAJOR_VERSION == 5))
 #ifdef USE_MIRROR_WINDOW
 	if (m_WindowStyle != DIRECT_MODE)
 	{
 		delete[] m_MirrorRGBImage;
+		MemoryStats::Free(MEMORY_HOST_BUFFER, MemoryStats::ImageBytes(m_HmdSession->Resolution.w, m_HmdSession->Resolution.h, 3));
 		glfwDestroyWindow(m_MirrorWindow);
 	}
 #endif // USE_MIRROR_WINDOW
 #endif
 
+	m_ResourceLoader.Terminate();
+	ProgramCache::Instance().Report();
 	glfwDestroyWindow(m_Window);
 	glfwTerminate();
+	DestroySession();
+
+#ifdef USE_OVRVISION
+	m_OVRVision.Terminate();
+#endif USE_OVRVISION
+#ifdef USE_ZEDMINI
+	m_ZedMini.Terminate();
+#endif // USE_ZEDMINI
+}
 
+void Oculus::DestroySession()
+{
 	if (m_HmdSession != nullptr)
 	{
 #if (OVR_PRODUCT_VERSION == 1)
@@ -704,23 +878,29 @@ void Oculus::Terminate()
 #endif
 #endif
 		ovr_Shutdown();
+		m_HmdSession = nullptr;
 	}
-
-#ifdef USE_OVRVISION
-	m_OVRVision.Terminate();
-#endif USE_OVRVISION
-#ifdef USE_ZEDMINI
-	m_ZedMini.Terminate();
-#endif // USE_ZEDMINI
 }
 
 void Oculus::UpdateTrackingData()
 {
 	m_FrameIndex++;
 
+	memset(&m_LatencyFrame, 0, sizeof(m_LatencyFrame));
+	m_LatencyFrame.Frame = m_FrameIndex;
+	m_LatencyFrame.SampleTime = ovr_GetTimeInSeconds();
+
+	// the navigation of this frame, for the *_NAV poses and CAVENavConvert*
+	{
+		std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+		m_LatchedNavigation[0] = m_Navigation.transform();
+		m_LatchedNavigation[1] = m_Navigation.inverse();
+	}
+
 #if (OVR_PRODUCT_VERSION == 1)
 	double frameTiming = ovr_GetPredictedDisplayTime(m_HmdSession, m_FrameIndex); // m_FrameIndex = 0 : Auto
 	ovrTrackingState trackingState = ovr_GetTrackingState(m_HmdSession, frameTiming, ovrTrue);
+	m_LatencyFrame.PredictedDisplayTime = frameTiming;
 #if (OVR_MINOR_VERSION >= 17)
 	ovr_CalcEyePoses(trackingState.HeadPose.ThePose, m_ViewScaleDesc.HmdToEyePose, m_LayerEyeFov.RenderPose);
 #else
@@ -730,6 +910,7 @@ void Oculus::UpdateTrackingData()
 #if (OVR_MAJOR_VERSION == 8)
 	double frameTiming = ovr_GetPredictedDisplayTime(m_HmdSession, m_FrameIndex); // m_FrameIndex = 0 : Auto
 	ovrTrackingState trackingState = ovr_GetTrackingState(m_HmdSession, frameTiming, ovrTrue);
+	m_LatencyFrame.PredictedDisplayTime = frameTiming;
 	ovr_CalcEyePoses(trackingState.HeadPose.ThePose, m_ViewScaleDesc.HmdToEyeViewOffset, m_LayerEyeFov.RenderPose);
 #elif (OVR_MAJOR_VERSION == 7)
 	ovrTrackingState trackingState = ovr_GetTrackingState(m_HmdSession, ovr_GetTimeInSeconds());
@@ -743,6 +924,24 @@ void Oculus::UpdateTrackingData()
 #endif
 #endif
 
+#if (OVR_PRODUCT_VERSION == 1)
+	StoreTrackingState(trackingState, m_CurrentControllerType.load() == OCULUS_TOUCH_RIGHT);
+#else
+	StoreTrackingState(trackingState, false);
+#endif
+
+	// the history is stamped with sample times, so it is filled with a
+	// sample of now rather than the prediction for the display
+	if (!m_IsTrackerRunning.load()) // otherwise the tracker thread fills the history
+	{
+		SampleTracking();
+	}
+}
+
+// positions and vectors of the tracked devices in CAVE and navigated
+// coordinates (no runtime calls, so that it also runs on synthetic states)
+void Oculus::StoreTrackingState(const ovrTrackingState& trackingState, bool hasHands)
+{
 	if (trackingState.StatusFlags & (ovrStatus_OrientationTracked | ovrStatus_PositionTracked))
 	{
 		// get position and vector of devices in real world
@@ -762,13 +961,14 @@ void Oculus::UpdateTrackingData()
 		m_HeadOrientation = OVR::Vector3f(angle_x, angle_y, angle_z);
 
 		// get position and vector of devices in navigated coordinate
+		OVR::Matrix4f navigationInverse = ToMatrix4f(m_LatchedNavigation[1]);
 		OVR::Matrix4f poseTmp = OVR::Matrix4f(pose);
 		OVR::Matrix4f newMatrix = OVR::Matrix4f(
 			poseTmp.M[0][0], poseTmp.M[0][1], poseTmp.M[0][2], poseTmp.M[0][3] * 10.0f / FEET_PER_METER,
 			poseTmp.M[1][0], poseTmp.M[1][1], poseTmp.M[1][2], poseTmp.M[1][3] * 10.0f / FEET_PER_METER,
 			poseTmp.M[2][0], poseTmp.M[2][1], poseTmp.M[2][2], poseTmp.M[2][3] * 10.0f / FEET_PER_METER,
 			poseTmp.M[3][0], poseTmp.M[3][1], poseTmp.M[3][2], poseTmp.M[3][3]);
-		finalRollPitchYaw = m_NavigationMatrix.Inverted() * newMatrix;
+		finalRollPitchYaw = navigationInverse * newMatrix;
 		m_HeadTranslationNav = OVR::Vector3f(
 			finalRollPitchYaw.M[0][3],
 			finalRollPitchYaw.M[1][3],
@@ -779,8 +979,23 @@ void Oculus::UpdateTrackingData()
 		finalRollPitchYaw.ToEulerAngles<OVR::Axis_Y, OVR::Axis_X, OVR::Axis_Z, OVR::Rotate_CCW, OVR::Handed_R>(&angle_x, &angle_y, &angle_z);
 		m_HeadOrientationNav = OVR::Vector3f(angle_x, angle_y, angle_z);
 
+		SensorFrame sensorFrame;
+		memset(&sensorFrame, 0, sizeof(sensorFrame));
+		sensorFrame.Frame = m_FrameIndex;
+		sensorFrame.Time = trackingState.HeadPose.TimeInSeconds;
+		sensorFrame.TrackedSensors = (1u << SENSOR_HEAD) | (1u << SENSOR_LEFT_EYE) | (1u << SENSOR_RIGHT_EYE);
+		StoreSensor(ovrPosef(pose), navigationInverse, sensorFrame.Sensor[SENSOR_HEAD]);
+		for (int eyeIndex = 0; eyeIndex < ovrEye_Count; eyeIndex++)
+		{
+#if (OVR_PRODUCT_VERSION == 1) || (OVR_MAJOR_VERSION > 5)
+			StoreSensor(m_LayerEyeFov.RenderPose[eyeIndex], navigationInverse, sensorFrame.Sensor[SENSOR_LEFT_EYE + eyeIndex]);
+#else
+			StoreSensor(m_EyePose[eyeIndex], navigationInverse, sensorFrame.Sensor[SENSOR_LEFT_EYE + eyeIndex]);
+#endif
+		}
+
 #if (OVR_PRODUCT_VERSION == 1)
-		if (m_CurrentControllerType == OCULUS_TOUCH_RIGHT)
+		if (hasHands)
 		{
 			ovrPosef         handPoses[2];
 			ovrInputState    inputState;
@@ -806,7 +1021,7 @@ void Oculus::UpdateTrackingData()
 					handPoseTmp.M[1][0], handPoseTmp.M[1][1], handPoseTmp.M[1][2], handPoseTmp.M[1][3] * 10.0f / FEET_PER_METER,
 					handPoseTmp.M[2][0], handPoseTmp.M[2][1], handPoseTmp.M[2][2], handPoseTmp.M[2][3] * 10.0f / FEET_PER_METER,
 					handPoseTmp.M[3][0], handPoseTmp.M[3][1], handPoseTmp.M[3][2], handPoseTmp.M[3][3]);
-				finalRollPitchYaw = m_NavigationMatrix.Inverted() * newMatrix;
+				finalRollPitchYaw = navigationInverse * newMatrix;
 				m_HandTranslationNav[i] = OVR::Vector3f(
 					finalRollPitchYaw.M[0][3],
 					finalRollPitchYaw.M[1][3],
@@ -814,12 +1029,110 @@ void Oculus::UpdateTrackingData()
 				m_HandVectorNav[i][VECTOR_RIGHT] = OVR::Vector3f( finalRollPitchYaw.M[0][0],  finalRollPitchYaw.M[1][0],  finalRollPitchYaw.M[2][0]);
 				m_HandVectorNav[i][VECTOR_UP   ] = OVR::Vector3f( finalRollPitchYaw.M[0][1],  finalRollPitchYaw.M[1][1],  finalRollPitchYaw.M[2][1]);
 				m_HandVectorNav[i][VECTOR_FRONT] = OVR::Vector3f(-finalRollPitchYaw.M[0][2], -finalRollPitchYaw.M[1][2], -finalRollPitchYaw.M[2][2]);
+
+				if (trackingState.HandStatusFlags[i] & (ovrStatus_OrientationTracked | ovrStatus_PositionTracked))
+				{
+					sensorFrame.TrackedSensors |= (1u << (SENSOR_LEFT_HAND + i));
+				}
+				StoreSensor(handPoses[i], navigationInverse, sensorFrame.Sensor[SENSOR_LEFT_HAND + i]);
 			}
 		}
 #endif
+
+		{
+			std::lock_guard<std::mutex> lock(m_SensorMutex);
+			m_SensorFrame = sensorFrame;
+		}
 	}
 }
 
+double Oculus::GetPredictedDisplayTime(int framesAhead)
+{
+#if (OVR_PRODUCT_VERSION == 1) || (OVR_MAJOR_VERSION == 8)
+	return ovr_GetPredictedDisplayTime(m_HmdSession, m_FrameIndex + framesAhead);
+#else
+	// no frame timing in the runtime: one measured frame interval per frame
+	float fps = (*m_FPS > 0.0f) ? *m_FPS : 75.0f;
+	return ovr_GetTimeInSeconds() + framesAhead / static_cast<double>(fps);
+#endif
+}
+
+bool Oculus::GetPredictedPose(int device, bool navigated, double time, Pose& pose)
+{
+	// the runtime predicts from its own sensor fusion; no latency marker, so
+	// that the latency timing of the display thread is left as it is
+#if (OVR_PRODUCT_VERSION == 1) || (OVR_MAJOR_VERSION == 8)
+	ovrTrackingState trackingState = ovr_GetTrackingState(m_HmdSession, time, ovrFalse);
+#elif (OVR_MAJOR_VERSION == 7)
+	ovrTrackingState trackingState = ovr_GetTrackingState(m_HmdSession, time);
+#else
+	ovrTrackingState trackingState = ovrHmd_GetTrackingState(m_HmdSession, time);
+#endif
+	unsigned int statusFlags = trackingState.StatusFlags;
+	ovrPosef trackedPose = trackingState.HeadPose.ThePose;
+	if (device != POSE_HEAD)
+	{
+#if (OVR_PRODUCT_VERSION == 1)
+		int hand = (device == POSE_LEFT_HAND) ? ovrHand_Left : ovrHand_Right;
+		statusFlags = (m_CurrentControllerType == OCULUS_TOUCH_RIGHT) ? trackingState.HandStatusFlags[hand] : 0;
+		trackedPose = trackingState.HandPoses[hand].ThePose;
+#else
+		statusFlags = 0;
+#endif
+	}
+
+	if (!(statusFlags & (ovrStatus_OrientationTracked | ovrStatus_PositionTracked)))
+	{
+		// extrapolated from the latest samples of the display thread
+		return m_PoseHistory.Extrapolate(time, device, navigated, pose);
+	}
+	ToCAVEPose(trackedPose, ToMatrix4f(GetLatchedNavigation(true)), navigated, pose);
+	return true;
+}
+
+void Oculus::GetSensorFrame(SensorFrame& frame)
+{
+	std::lock_guard<std::mutex> lock(m_SensorMutex);
+	frame = m_SensorFrame;
+}
+
+void Oculus::UpdateLatencyStats()
+{
+	m_LatencyStats.Submit(m_LatencyFrame);
+
+#if (OVR_PRODUCT_VERSION == 1)
+	// the frames composited since the last call; the runtime measures the
+	// motion-to-photon latency from the tracking state with the latency marker
+	ovrPerfStats perfStats;
+	if (OVR_SUCCESS(ovr_GetPerfStats(m_HmdSession, &perfStats)))
+	{
+		for (int i = 0; i < perfStats.FrameStatsCount; i++)
+		{
+			m_LatencyStats.SetMotionToPhoton(perfStats.FrameStats[i].AppFrameIndex, perfStats.FrameStats[i].AppMotionToPhotonLatency);
+		}
+	}
+#endif
+}
+
+void Oculus::StartSimulation(float rate, Callback callback)
+{
+	if (!callback)
+	{
+		m_Simulation.Stop();
+		return;
+	}
+	m_Simulation.Start(rate, std::move(callback), []() { return ovr_GetTimeInSeconds(); });
+}
+
+void Oculus::UpdateSimulation()
+{
+	// the simulation runs ahead by the latency of the display, so that its two
+	// latest steps bracket the display time of this frame
+	double displayTime = (m_LatencyFrame.PredictedDisplayTime != 0.0) ? m_LatencyFrame.PredictedDisplayTime : m_LatencyFrame.SampleTime;
+	m_Simulation.SetLead(displayTime - ovr_GetTimeInSeconds());
+	m_Simulation.Interpolate(displayTime);
+}
+
 void Oculus::PreProcess()
 {
 #if (OVR_PRODUCT_VERSION == 1)
@@ -843,6 +1156,7 @@ void Oculus::PreProcess()
 	// Get eye poses, feeding in correct IPD offset
 	ovr_GetEyePoses2(m_HmdSession, m_FrameIndex, ovrTrue, hmdToEyeOffset, eyeRenderPose, &sensorSampleTime);
 	m_LayerEyeFov.SensorSampleTime = sensorSampleTime;
+	m_LatencyFrame.SampleTime = sensorSampleTime;
 #endif // USE_ZEDMINI
 
 #else
@@ -872,6 +1186,8 @@ void Oculus::PreProcess()
 
 void Oculus::PostProcess()
 {
+	m_LatencyFrame.SubmitTime = ovr_GetTimeInSeconds();
+
 #if (OVR_PRODUCT_VERSION == 1)
 #ifdef STORE_LEFT_EYE_TEXTURE
 	const auto& vp0 = m_LayerEyeFov.Viewport[0];
@@ -896,9 +1212,22 @@ void Oculus::PostProcess()
 #endif
 
 #if (OVR_PRODUCT_VERSION == 1)
-	ovrLayerHeader* layerHeader = &m_LayerEyeFov.Header;
+	// redraw quad layers whose content has changed
+	RenderQuadLayers();
+
+	// the eye layer is submitted first, quad layers are composited over it
+	ovrLayerHeader* layerHeader[1 + MAX_QUAD_LAYERS];
+	int layerCount = 0;
+	layerHeader[layerCount++] = &m_LayerEyeFov.Header;
+	for (int i = 0; i < MAX_QUAD_LAYERS; i++)
+	{
+		if ((m_QuadLayer[i].State.load() == QUAD_LAYER_ACTIVE) && m_QuadLayer[i].HasContent)
+		{
+			layerHeader[layerCount++] = &m_QuadLayer[i].m_Layer.Header;
+		}
+	}
 //	ovr_SubmitFrame(m_HmdSession, 0, nullptr, &layerHeader, 1); // based on Developers Guide
-	ovr_SubmitFrame(m_HmdSession, 0, &m_ViewScaleDesc, &layerHeader, 1);
+	ovr_SubmitFrame(m_HmdSession, m_FrameIndex, &m_ViewScaleDesc, layerHeader, layerCount); // the index of the performance stats
 
 	// render to mirror window
 	GLuint mirrorTextureID;
@@ -962,6 +1291,8 @@ void Oculus::PostProcess()
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_HmdSession->Resolution.w, m_HmdSession->Resolution.h,
 			0, GL_RGB, GL_UNSIGNED_BYTE, m_MirrorRGBImage);
 		glBindTexture(GL_TEXTURE_2D, 0);
+		const long long mirrorTexBytes = MemoryStats::ImageBytes(m_HmdSession->Resolution.w, m_HmdSession->Resolution.h, 3) * 4 / 3; // with mipmaps
+		MemoryStats::Allocate(MEMORY_GPU_RENDER_TARGET, mirrorTexBytes);
 
 		// render texture image to mirror window
 		glClearColor(0, 0, 0, 0);
@@ -996,6 +1327,7 @@ void Oculus::PostProcess()
 		glBindTexture(GL_TEXTURE_2D, 0);
 		glDisable(GL_TEXTURE_2D);
 		glDeleteTextures(1, &mirrorTexID);
+		MemoryStats::Free(MEMORY_GPU_RENDER_TARGET, mirrorTexBytes);
 
 		glfwSwapBuffers(m_MirrorWindow);
 
@@ -1039,6 +1371,22 @@ void Oculus::SetMatrix(int eyeIndex)
 #endif // STORE_LEFT_EYE_TEXTURE
 #endif
 
+	OVR::Matrix4f viewMatrix = EyeViewMatrix(eyeIndex);
+//	OVR::Matrix4f modelViewMatrix = viewMatrix;
+
+	glEnable(GL_DEPTH_TEST);
+
+	glUseProgram(0);
+
+	glMatrixMode(GL_PROJECTION);
+	glLoadMatrixf(&(m_ProjectionMatrix[eyeIndex].Transposed().M[0][0]));
+	glMatrixMode(GL_MODELVIEW);
+//	glLoadMatrixf(&(modelViewMatrix.Transposed().M[0][0]));
+	glLoadMatrixf(&(viewMatrix.Transposed().M[0][0]));
+}
+
+OVR::Matrix4f Oculus::EyeViewMatrix(int eyeIndex)
+{
 	OVR::Matrix4f rollPitchYaw = OVR::Matrix4f::RotationY(0.0f);
 #if ((OVR_PRODUCT_VERSION == 0) && (OVR_MAJOR_VERSION == 5))
 	OVR::Matrix4f finalRollPitchYaw =
@@ -1055,109 +1403,199 @@ void Oculus::SetMatrix(int eyeIndex)
 	OVR::Vector3f shiftedEyePos =
 		rollPitchYaw.Transform(m_LayerEyeFov.RenderPose[eyeIndex].Position) * 10.0f;
 #endif
-	OVR::Matrix4f viewMatrix = OVR::Matrix4f::LookAtRH(shiftedEyePos, shiftedEyePos + finalForward, finalUp);
-//	OVR::Matrix4f modelViewMatrix = viewMatrix;
+	return OVR::Matrix4f::LookAtRH(shiftedEyePos, shiftedEyePos + finalForward, finalUp);
+}
 
-	glEnable(GL_DEPTH_TEST);
+void Oculus::UpdateFrustum()
+{
+	// the draw callback is called with P * V * S, and P * V * S * N after CAVENavTransform()
+	OVR::Matrix4f scaleMatrix = OVR::Matrix4f::Scaling(FEET_PER_METER);
+	OVR::Matrix4f navigationMatrix = ToMatrix4f(GetLatchedNavigation(false));
 
-	glUseProgram(0);
+	Frustum frustum[2][ovrEye_Count + 1];
+	for (int eyeIndex = 0; eyeIndex < ovrEye_Count; eyeIndex++)
+	{
+		OVR::Matrix4f clipMatrix = m_ProjectionMatrix[eyeIndex] * EyeViewMatrix(eyeIndex) * scaleMatrix;
+		frustum[0][eyeIndex].SetFromMatrix(clipMatrix.M);
+		frustum[1][eyeIndex].SetFromMatrix((clipMatrix * navigationMatrix).M);
+	}
+	frustum[0][ovrEye_Count].SetStereo(frustum[0][ovrEye_Left], frustum[0][ovrEye_Right]);
+	frustum[1][ovrEye_Count].SetStereo(frustum[1][ovrEye_Left], frustum[1][ovrEye_Right]);
 
-	glMatrixMode(GL_PROJECTION);
-	glLoadMatrixf(&(m_ProjectionMatrix[eyeIndex].Transposed().M[0][0]));
-	glMatrixMode(GL_MODELVIEW);
-//	glLoadMatrixf(&(modelViewMatrix.Transposed().M[0][0]));
-	glLoadMatrixf(&(viewMatrix.Transposed().M[0][0]));
+	std::lock_guard<std::mutex> lock(m_FrustumMutex);
+	memcpy(m_Frustum, frustum, sizeof(m_Frustum));
 }
 
-void Oculus::Translate(float x, float y, float z)
+void Oculus::GetFrustum(int eyeIndex, bool navigated, float planes[6][4])
 {
-	OVR::Matrix4f currentMatrix = m_NavigationMatrix;
-	m_NavigationMatrix = OVR::Matrix4f::Translation(-x, -y, -z) * currentMatrix;
+	std::lock_guard<std::mutex> lock(m_FrustumMutex);
+	memcpy(planes, m_Frustum[navigated ? 1 : 0][eyeIndex].Plane, sizeof(m_Frustum[0][0].Plane));
 }
 
-void Oculus::Rotate(float angle_degree, char axis)
+void Oculus::UpdateLOD()
 {
-	float angle_radian = -angle_degree * (float)M_PI / 180.0f;
-	OVR::Matrix4f currentMatrix = m_NavigationMatrix;
-	switch (tolower(axis))
+	OVR::Matrix4f scaleMatrix = OVR::Matrix4f::Scaling(FEET_PER_METER);
+	Affine navigationInverse = GetLatchedNavigation(true);
+
+	LodView view, navigatedView;
+	view.PixelScale = 0.0f;
+	for (int eyeIndex = 0; eyeIndex < ovrEye_Count; eyeIndex++)
 	{
-		case 'x':
-			m_NavigationMatrix = OVR::Matrix4f::RotationX(angle_radian) * currentMatrix;
-			break;
-		case 'y':
-			m_NavigationMatrix = OVR::Matrix4f::RotationY(angle_radian) * currentMatrix;
-			break;
-		case 'z':
-			m_NavigationMatrix = OVR::Matrix4f::RotationZ(angle_radian) * currentMatrix;
-			break;
-		default:
-			break;
+		OVR::Matrix4f modelViewMatrix = EyeViewMatrix(eyeIndex) * scaleMatrix;
+		OVR::Vector3f eyePosition = modelViewMatrix.Inverted().GetTranslation();
+		view.EyePosition[eyeIndex][0] = eyePosition.x;
+		view.EyePosition[eyeIndex][1] = eyePosition.y;
+		view.EyePosition[eyeIndex][2] = eyePosition.z;
+		AffineTransformPoint(navigationInverse, view.EyePosition[eyeIndex], navigatedView.EyePosition[eyeIndex]);
+
+#if ((OVR_PRODUCT_VERSION == 0) && (OVR_MAJOR_VERSION == 5))
+		int viewportHeight = m_EyeRenderViewport[eyeIndex].Size.h;
+#else
+		int viewportHeight = m_LayerEyeFov.Viewport[eyeIndex].Size.h;
+#endif
+		float pixelScale = 0.5f * viewportHeight * m_ProjectionMatrix[eyeIndex].M[1][1];
+		view.PixelScale = std::max(view.PixelScale, pixelScale);
+	}
+	navigatedView.PixelScale = view.PixelScale;
+
+	{
+		std::lock_guard<std::mutex> lock(m_FrustumMutex);
+		view.View = m_Frustum[0][ovrEye_Count];
+		navigatedView.View = m_Frustum[1][ovrEye_Count];
 	}
+
+	m_LodSelector.Select(view, navigatedView);
+}
+
+void Oculus::Translate(float x, float y, float z)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	m_Navigation.PreTranslate(-x, -y, -z);
+}
+
+void Oculus::Rotate(float angle_degree, char axis)
+{
+	double angle_radian = -angle_degree * M_PI / 180.0;
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	m_Navigation.PreRotate(angle_radian, axis);
 }
 
 void Oculus::Scale(float x, float y, float z)
 {
-	OVR::Matrix4f currentMatrix = m_NavigationMatrix;
-	m_NavigationMatrix = OVR::Matrix4f::Scaling(1.0f / x, 1.0f / y, 1.0f / z) * currentMatrix;
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	m_Navigation.PreScale(1.0 / x, 1.0 / y, 1.0 / z);
 }
 
 void Oculus::WorldTranslate(float x, float y, float z)
 {
-	m_NavigationMatrix *= OVR::Matrix4f::Translation(-x, -y, -z);
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	m_Navigation.PostTranslate(-x, -y, -z);
 }
 
 void Oculus::WorldRotate(float angle_degree, char axis)
 {
-	float angle_radian = -angle_degree * M_PI / 180.0f;
-	switch (tolower(axis))
-	{
-		case 'x':
-			m_NavigationMatrix *= OVR::Matrix4f::RotationX(angle_radian);
-			break;
-		case 'y':
-			m_NavigationMatrix *= OVR::Matrix4f::RotationY(angle_radian);
-			break;
-		case 'z':
-			m_NavigationMatrix *= OVR::Matrix4f::RotationZ(angle_radian);
-			break;
-		default:
-			break;
-	}
+	double angle_radian = -angle_degree * M_PI / 180.0;
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	m_Navigation.PostRotate(angle_radian, axis);
 }
 
 void Oculus::WorldScale(float x, float y, float z)
 {
-	m_NavigationMatrix *= OVR::Matrix4f::Scaling(1.0f / x, 1.0f / y, 1.0f / z);
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	m_Navigation.PostScale(1.0 / x, 1.0 / y, 1.0 / z);
 }
 
 OVR::Matrix4f Oculus::GetNavigationMatrix()
 {
-	return m_NavigationMatrix;
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	return ToMatrix4f(m_Navigation.transform());
+}
+
+void Oculus::GetNavigationMatrix(double matrix[4][4])
+{
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	m_Navigation.GetMatrix(matrix);
 }
 
 void Oculus::LoadNavigationMatrix(OVR::Matrix4f matrix)
 {
-	m_NavigationMatrix = matrix;
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	m_Navigation.Load(matrix.M);
+}
+
+void Oculus::LoadNavigationMatrix(const double matrix[4][4])
+{
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	m_Navigation.Load(matrix);
+}
+
+void Oculus::StoreNavigationMatrix()
+{
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	m_Navigation_Backup = m_Navigation;
+}
+
+void Oculus::RestoreNavigationMatrix()
+{
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	m_Navigation = m_Navigation_Backup;
 }
 
 void Oculus::SetNavigationMatrix()
 {
 //	glMatrixMode(GL_MODELVIEW_MATRIX);
 	glMatrixMode(GL_MODELVIEW);
-	glMultMatrixf(&(m_NavigationMatrix.Transposed().M[0][0]));
+	glMultMatrixf(&(GetNavigationMatrix().Transposed().M[0][0]));
 }
 
 void Oculus::SetNavigationInverseMatrix()
 {
 //	glMatrixMode(GL_MODELVIEW_MATRIX);
+	OVR::Matrix4f navigationInverse;
+	{
+		std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+		navigationInverse = ToMatrix4f(m_Navigation.inverse());
+	}
 	glMatrixMode(GL_MODELVIEW);
-	glMultMatrixf(&((m_NavigationMatrix.Transposed()).Inverted().M[0][0]));
+	glMultMatrixf(&(navigationInverse.Transposed().M[0][0]));
+}
+
+void Oculus::SetNavigationMatrixRelative(const double origin[3])
+{
+	// V * S * N * T(origin) is composed in double, so that the large
+	// translations of N and origin cancel before the conversion to float
+	OVR::Matrix4f viewMatrix = EyeViewMatrix(m_CurrentEyeIndex) * OVR::Matrix4f::Scaling(FEET_PER_METER);
+	Affine view, originTranslation, modelView;
+	AffineFromMatrix(viewMatrix.M, view);
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			originTranslation.Linear[i][j] = (i == j) ? 1.0 : 0.0;
+		}
+		originTranslation.Translation[i] = origin[i];
+	}
+	{
+		std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+		AffineMultiply(m_Navigation.transform(), originTranslation, modelView);
+	}
+	AffineMultiply(view, modelView, modelView);
+
+	glMatrixMode(GL_MODELVIEW);
+	glLoadMatrixf(&(ToMatrix4f(modelView).Transposed().M[0][0]));
+}
+
+Affine Oculus::GetLatchedNavigation(bool inverse)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	return m_LatchedNavigation[inverse ? 1 : 0];
 }
 
 void Oculus::SetNavigationMatrixIdentity()
 {
 //	glMatrixMode(GL_MODELVIEW_MATRIX);
-	m_NavigationMatrix.SetIdentity();
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	m_Navigation.SetIdentity();
 }
 
 void Oculus::MultiNavigationMatrix(float matrix[4][4])
@@ -1167,8 +1605,8 @@ void Oculus::MultiNavigationMatrix(float matrix[4][4])
 		matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1],
 		matrix[0][2], matrix[1][2], matrix[2][2], matrix[3][2],
 		matrix[0][3], matrix[1][3], matrix[2][3], matrix[3][3]);
-	OVR::Matrix4f currentMatrix = m_NavigationMatrix;
-	m_NavigationMatrix = mat4 * currentMatrix;
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	m_Navigation.PreMultiply(mat4.M);
 }
 
 void Oculus::PreMultiNavigationMatrix(float matrix[4][4])
@@ -1178,24 +1616,281 @@ void Oculus::PreMultiNavigationMatrix(float matrix[4][4])
 		matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1],
 		matrix[0][2], matrix[1][2], matrix[2][2], matrix[3][2],
 		matrix[0][3], matrix[1][3], matrix[2][3], matrix[3][3]);
-	m_NavigationMatrix *= mat4;
+	std::lock_guard<std::recursive_mutex> lock(m_NavigationMutex);
+	m_Navigation.PostMultiply(mat4.M);
+}
+
+int Oculus::CreateQuadLayer(int width, int height, bool headLocked)
+{
+#if (OVR_PRODUCT_VERSION == 0)
+	return -1; // quad layers need Oculus SDK 1.x
+#else
+	if ((width <= 0) || (height <= 0))
+	{
+		return -1;
+	}
+
+	std::lock_guard<std::mutex> lock(m_QuadLayerMutex);
+	for (int i = 0; i < MAX_QUAD_LAYERS; i++)
+	{
+		QuadLayer& layer = m_QuadLayer[i];
+		if (layer.State.load() != QUAD_LAYER_FREE)
+		{
+			continue;
+		}
+		layer.Width        = width;
+		layer.Height       = height;
+		layer.IsHeadLocked = headLocked;
+		layer.HasContent   = false;
+		layer.m_Function.Reset();
+		// default: 2x2 feet panel placed in front of the user
+		layer.Position[0] = 0.0f;
+		layer.Position[1] = headLocked ? 0.0f : 5.0f;
+		layer.Position[2] = -3.0f;
+		layer.Angle[0] = layer.Angle[1] = layer.Angle[2] = 0.0f;
+		layer.Size[0] = 2.0f;
+		layer.Size[1] = 2.0f * static_cast<float>(height) / static_cast<float>(width);
+		layer.IsDirty.store(true);
+		layer.State.store(QUAD_LAYER_PENDING); // swap chain is created by the display thread
+		return i;
+	}
+
+	std::cout << "WARNING: no more quad layers are available." << std::endl;
+	return -1;
+#endif
+}
+
+void Oculus::DestroyQuadLayer(int layerID)
+{
+	if ((layerID < 0) || (layerID >= MAX_QUAD_LAYERS))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_QuadLayerMutex);
+	int state = m_QuadLayer[layerID].State.load();
+	if (state == QUAD_LAYER_PENDING)
+	{
+		m_QuadLayer[layerID].State.store(QUAD_LAYER_FREE);
+	}
+	else if (state == QUAD_LAYER_ACTIVE)
+	{
+		m_QuadLayer[layerID].State.store(QUAD_LAYER_RELEASE);
+	}
+}
+
+void Oculus::SetQuadLayerFunction(int layerID, Callback callback)
+{
+	if ((layerID < 0) || (layerID >= MAX_QUAD_LAYERS))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_QuadLayerMutex);
+	m_QuadLayer[layerID].m_Function = std::move(callback);
+	m_QuadLayer[layerID].IsDirty.store(true);
+}
+
+void Oculus::SetQuadLayerPose(int layerID, float position[3], float angle[3], float size[2])
+{
+	if ((layerID < 0) || (layerID >= MAX_QUAD_LAYERS))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_QuadLayerMutex);
+	QuadLayer& layer = m_QuadLayer[layerID];
+	for (int i = 0; i < 3; i++)
+	{
+		if (position != nullptr) layer.Position[i] = position[i];
+		if (angle != nullptr) layer.Angle[i] = angle[i];
+	}
+	if (size != nullptr)
+	{
+		layer.Size[0] = size[0];
+		layer.Size[1] = size[1];
+	}
+}
+
+void Oculus::UpdateQuadLayer(int layerID)
+{
+	if ((layerID < 0) || (layerID >= MAX_QUAD_LAYERS))
+	{
+		return;
+	}
+	m_QuadLayer[layerID].IsDirty.store(true);
+}
+
+int Oculus::EnqueueUpload(Callback callback)
+{
+	if (!callback)
+	{
+		return -1;
+	}
+	return m_ResourceLoader.Enqueue(std::move(callback));
+}
+
+void Oculus::WaitUpload(int uploadID)
+{
+	// without the loader thread, pending uploads are executed by the display thread
+	if (!m_ResourceLoader.IsRunning() && IsDisplayThread())
+	{
+		m_ResourceLoader.ExecuteOnCurrentContext();
+	}
+	m_ResourceLoader.Wait(uploadID);
+}
+
+void Oculus::RenderQuadLayers()
+{
+#if (OVR_PRODUCT_VERSION == 1)
+	for (int i = 0; i < MAX_QUAD_LAYERS; i++)
+	{
+		QuadLayer& layer = m_QuadLayer[i];
+		int state = layer.State.load();
+		if (state == QUAD_LAYER_FREE)
+		{
+			continue;
+		}
+
+		if (state == QUAD_LAYER_RELEASE)
+		{
+			if (layer.m_SwapChain != 0)
+			{
+				MemoryStats::Free(MEMORY_GPU_QUAD_LAYER, SwapChainBytes(m_HmdSession, layer.m_SwapChain, layer.Width, layer.Height));
+				ovr_DestroyTextureSwapChain(m_HmdSession, layer.m_SwapChain);
+				layer.m_SwapChain = 0;
+			}
+			layer.HasContent = false;
+			layer.State.store(QUAD_LAYER_FREE);
+			continue;
+		}
+
+		if (state == QUAD_LAYER_PENDING)
+		{
+			ovrTextureSwapChainDesc desc = {};
+			desc.Type = ovrTexture_2D;
+			desc.ArraySize = 1;
+			desc.Format = OVR_FORMAT_R8G8B8A8_UNORM_SRGB;
+			desc.Width  = layer.Width;
+			desc.Height = layer.Height;
+			desc.MipLevels = 1;
+			desc.SampleCount = 1;
+			desc.StaticImage = ovrFalse;
+			if (OVR_FAILURE(ovr_CreateTextureSwapChainGL(m_HmdSession, &desc, &layer.m_SwapChain)))
+			{
+				std::cout << "ERROR: Cound not create ovrTextureSwapChain for a quad layer." << std::endl;
+				layer.m_SwapChain = 0;
+				int pending = QUAD_LAYER_PENDING;
+				layer.State.compare_exchange_strong(pending, QUAD_LAYER_FREE);
+				continue;
+			}
+
+			MemoryStats::Allocate(MEMORY_GPU_QUAD_LAYER, SwapChainBytes(m_HmdSession, layer.m_SwapChain, layer.Width, layer.Height));
+
+			memset(&layer.m_Layer, 0, sizeof(ovrLayerQuad));
+			layer.m_Layer.Header.Type = ovrLayerType_Quad;
+			layer.m_Layer.Header.Flags =
+				ovrLayerFlag_TextureOriginAtBottomLeft | ovrLayerFlag_HighQuality;
+			if (layer.IsHeadLocked)
+			{
+				layer.m_Layer.Header.Flags |= ovrLayerFlag_HeadLocked;
+			}
+			layer.m_Layer.ColorTexture = layer.m_SwapChain;
+			layer.m_Layer.Viewport = OVR::Recti(0, 0, layer.Width, layer.Height);
+
+			// the app thread may have destroyed the layer meanwhile
+			int pending = QUAD_LAYER_PENDING;
+			if (!layer.State.compare_exchange_strong(pending, QUAD_LAYER_ACTIVE))
+			{
+				MemoryStats::Free(MEMORY_GPU_QUAD_LAYER, SwapChainBytes(m_HmdSession, layer.m_SwapChain, layer.Width, layer.Height));
+				ovr_DestroyTextureSwapChain(m_HmdSession, layer.m_SwapChain);
+				layer.m_SwapChain = 0;
+				continue;
+			}
+		}
+
+		// pose and size may be changed by the app thread at any time
+		Callback function;
+		{
+			std::lock_guard<std::mutex> lock(m_QuadLayerMutex);
+			const float scale = FEET_PER_METER / 10.0f; // CAVE coordinate to meters
+			OVR::Quatf orientation =
+				OVR::Quatf(OVR::Vector3f(0.0f, 1.0f, 0.0f), layer.Angle[1] * (float)M_PI / 180.0f) *
+				OVR::Quatf(OVR::Vector3f(1.0f, 0.0f, 0.0f), layer.Angle[0] * (float)M_PI / 180.0f) *
+				OVR::Quatf(OVR::Vector3f(0.0f, 0.0f, 1.0f), layer.Angle[2] * (float)M_PI / 180.0f);
+			layer.m_Layer.QuadPoseCenter.Orientation = orientation;
+			layer.m_Layer.QuadPoseCenter.Position.x = layer.Position[0] * scale;
+			layer.m_Layer.QuadPoseCenter.Position.y = layer.Position[1] * scale;
+			layer.m_Layer.QuadPoseCenter.Position.z = layer.Position[2] * scale;
+			layer.m_Layer.QuadSize.x = layer.Size[0] * scale;
+			layer.m_Layer.QuadSize.y = layer.Size[1] * scale;
+
+			// redraw the content only when the app has requested it
+			if (m_IsInitFunctionExecuted && layer.m_Function && layer.IsDirty.exchange(false))
+			{
+				function = layer.m_Function;
+			}
+		}
+		if (!function)
+		{
+			continue;
+		}
+
+		if (m_QuadLayerFBO == 0)
+		{
+			glGenFramebuffers(1, &m_QuadLayerFBO);
+		}
+
+		int currentIndex = 0;
+		ovr_GetTextureSwapChainCurrentIndex(m_HmdSession, layer.m_SwapChain, &currentIndex);
+		GLuint currentTextureID = 0;
+		ovr_GetTextureSwapChainBufferGL(m_HmdSession, layer.m_SwapChain, currentIndex, &currentTextureID);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_QuadLayerFBO);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, currentTextureID, 0);
+		glViewport(0, 0, layer.Width, layer.Height);
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		// the content is drawn in normalized device coordinates ([-1, 1] x [-1, 1])
+		glPushAttrib(GL_ENABLE_BIT);
+		glDisable(GL_DEPTH_TEST);
+		glUseProgram(0);
+		glMatrixMode(GL_PROJECTION);
+		glPushMatrix();
+		glLoadIdentity();
+		glMatrixMode(GL_MODELVIEW);
+		glPushMatrix();
+		glLoadIdentity();
+		function();
+		glMatrixMode(GL_PROJECTION);
+		glPopMatrix();
+		glMatrixMode(GL_MODELVIEW);
+		glPopMatrix();
+		glPopAttrib();
+
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		ovr_CommitTextureSwapChain(m_HmdSession, layer.m_SwapChain);
+		layer.HasContent = true;
+	}
+#endif
 }
 
 #if (OVR_PRODUCT_VERSION == 1)
 void Oculus::SwitchControllerType()
 {
-	m_CurrentControllerType++;
-	m_CurrentControllerType %= static_cast<int>(ENUM_CONTROLLER_TYPE_SIZE);
-	if ((m_CurrentControllerType == XBOX_CONTROLLER) && (m_IsConnected[XBOX_CONTROLLER] == false))
+	uint controllerType = (m_CurrentControllerType.load() + 1) % static_cast<int>(ENUM_CONTROLLER_TYPE_SIZE);
+	if ((controllerType == XBOX_CONTROLLER) && (m_IsConnected[XBOX_CONTROLLER] == false))
 	{
-		m_CurrentControllerType = OCULUS_TOUCH_RIGHT;
+		controllerType = OCULUS_TOUCH_RIGHT;
 	}
-	if ((m_CurrentControllerType == OCULUS_TOUCH_RIGHT) && (m_IsConnected[OCULUS_TOUCH_RIGHT] == false))
+	if ((controllerType == OCULUS_TOUCH_RIGHT) && (m_IsConnected[OCULUS_TOUCH_RIGHT] == false))
 	{
-		m_CurrentControllerType = MOUSE;
+		controllerType = MOUSE;
 	}
+	m_CurrentControllerType.store(controllerType); // read by the tracker thread
 	std::cout << "Switch ControllerType to: ";
-	switch (m_CurrentControllerType)
+	switch (controllerType)
 	{
 		case MOUSE:
 			std::cout << "MOUSE\n";
@@ -1230,6 +1925,10 @@ void Oculus::GetSnap()
 
 bool Oculus::GetKey(int key)
 {
+	if (!IsInitialized())
+	{
+		return false; // no window yet
+	}
 	Oculus* instance = reinterpret_cast<Oculus*>(glfwGetWindowUserPointer(m_Window));
 	bool result = false;
 	if (instance != nullptr)
@@ -1241,6 +1940,10 @@ bool Oculus::GetKey(int key)
 
 int Oculus::GetMouseButton(int button)
 {
+	if (!IsInitialized())
+	{
+		return GLFW_RELEASE;
+	}
 	Oculus* instance = reinterpret_cast<Oculus*>(glfwGetWindowUserPointer(m_Window));
 	int result = GLFW_RELEASE;
 	if (instance != nullptr)
@@ -1252,12 +1955,18 @@ int Oculus::GetMouseButton(int button)
 
 void Oculus::StartThread()
 {
-	DWORD m_MainThreadID = GetCurrentThreadId();
+	m_MainThreadID = GetCurrentThreadId();
+	m_StartupTimer.Start();
 
 	m_HMutex = CreateMutex(NULL, FALSE, NULL);
 	m_HRender = (HANDLE)_beginthreadex(0, 0, MainThreadLauncherEX, reinterpret_cast<void*>(this), 0, 0);
+}
 
-	while(!m_IsInitializedGLFW.load()); // waiting the initialization of GLFW
+bool Oculus::WaitForInit()
+{
+	std::unique_lock<std::mutex> lock(m_InitMutex);
+	m_InitCondition.wait(lock, [this]() { return m_IsInitializedGLFW.load() || m_IsInitFailed; });
+	return !m_IsInitFailed;
 }
 
 void Oculus::StopThread()
@@ -1268,23 +1977,113 @@ void Oculus::StopThread()
 
 void Oculus::MainThreadEX()
 {
-	DWORD m_DisplayThreadID = GetCurrentThreadId();
+	m_DisplayThreadID = GetCurrentThreadId();
+	ThreadScheduling::Apply(THREAD_DISPLAY);
+
+	// startup: the runtime session and the camera are opened on their own
+	// threads while GLFW starts; the window takes the size of the HMD and the
+	// camera textures need the render context. Failures are handled here
+	// after the joins.
+	bool isRuntimeReady = false;
+	std::thread runtimeThread([this, &isRuntimeReady]()
+	{
+		int phase = m_StartupTimer.Begin("runtime");
+		isRuntimeReady = Init();
+		m_StartupTimer.End(phase);
+	});
+#if defined(USE_OVRVISION) || defined(USE_ZEDMINI)
+	bool isCameraOpen = false;
+	std::thread cameraThread([this, &isCameraOpen]()
+	{
+		int phase = m_StartupTimer.Begin("camera open");
+		isCameraOpen = OpenCamera();
+		m_StartupTimer.End(phase);
+	});
+#endif
+	int phase = m_StartupTimer.Begin("GLFW");
+	bool isGLFWReady = InitGLFW();
+	m_StartupTimer.End(phase);
 
-	Init();
+	runtimeThread.join();
+	if (!isRuntimeReady || !isGLFWReady)
+	{
+#if defined(USE_OVRVISION) || defined(USE_ZEDMINI)
+		cameraThread.join();
+#endif
+		std::cout << "CLCL: The startup failed (" << (isRuntimeReady ? "GLFW" : "HMD runtime") << ")." << std::endl;
+		// the teardown of Terminate() for what has been opened, so that
+		// CAVEInit() can be called again
+		if (isGLFWReady)
+		{
+			glfwTerminate();
+		}
+		DestroySession();
+#ifdef USE_OVRVISION
+		m_OVRVision.Terminate();
+#endif // USE_OVRVISION
+#ifdef USE_ZEDMINI
+		m_ZedMini.Terminate();
+#endif // USE_ZEDMINI
+		{
+			// CAVEWaitForInit() returns false
+			std::lock_guard<std::mutex> lock(m_InitMutex);
+			m_IsInitFailed = true;
+		}
+		m_InitCondition.notify_all();
+		return;
+	}
+	phase = m_StartupTimer.Begin("window, GL");
 	InitGL();
+	m_StartupTimer.End(phase);
+
+#if defined(USE_OVRVISION) || defined(USE_ZEDMINI)
+	cameraThread.join();
+	if (!isCameraOpen)
+	{
+		std::cout << "CLCL: The camera is not available." << std::endl;
+	}
+	phase = m_StartupTimer.Begin("camera GL");
+	InitCamera();
+	m_StartupTimer.End(phase);
+#endif
+	phase = m_StartupTimer.Begin("buffers");
 	CreateBuffers();
+	m_StartupTimer.End(phase);
+	m_StartupTimer.Log();
 
-	m_IsInitializedGLFW.store(true);
+	{
+		std::lock_guard<std::mutex> lock(m_InitMutex);
+		m_IsInitializedGLFW.store(true);
+	}
+	m_InitCondition.notify_all();
+	if (m_TrackerRate.load() > 0)
+	{
+		StartTracker();
+	}
 
 	int frameCounter = 0;
 	double t, t0;
 	t0 = glfwGetTime();
 	while (m_IsThreadRunning)
 	{
+		ThreadScheduling::Apply(THREAD_DISPLAY);
+		ThreadScheduling::RecordPeriod(THREAD_DISPLAY);
+		FrameAllocator::BeginFrame();
+		m_FrameTasks.BeginFrame();
+		TakePendingCallbacks();
 		ExecInitCallback();
+		if (!m_ResourceLoader.IsRunning())
+		{
+			m_ResourceLoader.ExecuteOnCurrentContext();
+		}
 		UpdateTrackingData();
 		ExecIdleCallback();
+		m_FrameTasks.Run();
 		PreProcess();
+		UpdateFrustum();
+		UpdateLOD();
+		m_LatencyStats.LatchAppData(m_LatencyFrame.AppDataVersion, m_LatencyFrame.AppDataTime);
+		UpdateSimulation();
 		for (int eyeIndex = 0; eyeIndex < ovrEye_Count; eyeIndex++)
 		{
 			SetMatrix(eyeIndex);
@@ -1293,7 +2092,12 @@ void Oculus::MainThreadEX()
 			ExecDrawCallback();
 			glPopMatrix();
 		}
+		m_FrameTasks.EndWork();
 		PostProcess();
+		m_FrameJobs.JoinFrame(); // jobs of this frame ran while it was rendered
+		UpdateLatencyStats();
+		MemoryStats::EndFrame(ovr_GetTimeInSeconds());
+		ThreadScheduling::EndFrame(ovr_GetTimeInSeconds());
 
 		t = glfwGetTime();
 		if ((t - t0) > 1.0 || frameCounter == 0)
@@ -1305,10 +2109,50 @@ void Oculus::MainThreadEX()
 		frameCounter++;
 	}
 
+	m_Simulation.Stop();
+	m_FrameJobs.JoinFrame();
+	TakePendingCallbacks();
 	ExecStopCallback();
+	StopTracker(); // before the session is destroyed
 	Terminate();
 }
 
+void Oculus::SetCallback(int type, Callback callback)
+{
+	Callback replaced;
+	{
+		std::lock_guard<std::mutex> lock(m_CallbackMutex);
+		replaced = std::move(m_PendingCallback[type]); // set again before the display thread took it
+		m_PendingCallback[type] = std::move(callback);
+		m_IsCallbackPending[type] = true;
+		m_HasPendingCallback.store(true);
+	}
+}
+
+void Oculus::TakePendingCallbacks()
+{
+	if (!m_HasPendingCallback.load())
+	{
+		return;
+	}
+	// the callbacks replaced here are destroyed after the lock is released,
+	// and never while one of them runs
+	Callback replaced[CALLBACK_TYPE_COUNT];
+	{
+		std::lock_guard<std::mutex> lock(m_CallbackMutex);
+		for (int i = 0; i < CALLBACK_TYPE_COUNT; i++)
+		{
+			if (m_IsCallbackPending[i])
+			{
+				replaced[i] = std::move(m_Callback[i]);
+				m_Callback[i] = std::move(m_PendingCallback[i]);
+				m_IsCallbackPending[i] = false;
+			}
+		}
+		m_HasPendingCallback.store(false);
+	}
+}
+
 unsigned __stdcall Oculus::MainThreadLauncherEX(void *obj)
 {
 	reinterpret_cast<Oculus*>(obj)->MainThreadEX();
@@ -1316,6 +2160,133 @@ unsigned __stdcall Oculus::MainThreadLauncherEX(void *obj)
 	return 0;
 }
 
+void Oculus::SetTrackerRate(int rate)
+{
+	m_TrackerRate.store(std::min(rate, MAX_TRACKER_RATE));
+	if (!m_IsInitializedGLFW.load())
+	{
+		return; // started by the display thread after the initialization
+	}
+	if (rate > 0)
+	{
+		StartTracker();
+	}
+	else
+	{
+		StopTracker();
+	}
+}
+
+void Oculus::StartTracker()
+{
+	std::lock_guard<std::mutex> lock(m_TrackerMutex);
+	if (m_HTracker != nullptr)
+	{
+		return;
+	}
+	m_IsTrackerRunning.store(true);
+	// suspended until its ID is set, so that IsTrackerThread() holds from its first instruction
+	unsigned threadID = 0;
+	m_HTracker = (HANDLE)_beginthreadex(0, 0, TrackerThreadLauncher, reinterpret_cast<void*>(this), CREATE_SUSPENDED, &threadID);
+	m_TrackerThreadID.store(threadID);
+	ResumeThread(m_HTracker);
+	std::cout << "CLCL: tracker thread started (" << m_TrackerRate.load() << " Hz)" << std::endl;
+}
+
+void Oculus::StopTracker()
+{
+	std::lock_guard<std::mutex> lock(m_TrackerMutex);
+	if (m_HTracker == nullptr)
+	{
+		return;
+	}
+	m_IsTrackerRunning.store(false);
+	WaitForSingleObject(m_HTracker, INFINITE);
+	CloseHandle(m_HTracker);
+	m_HTracker = nullptr;
+	m_TrackerThreadID.store(0);
+}
+
+void Oculus::TrackerThread()
+{
+	ThreadScheduling::Apply(THREAD_TRACKER);
+
+	WaitTimer timer;
+	double next = ovr_GetTimeInSeconds();
+	while (m_IsTrackerRunning.load())
+	{
+		SampleTracking();
+
+		next += 1.0 / std::max(m_TrackerRate.load(), 1);
+		double now = ovr_GetTimeInSeconds();
+		if (next < now)
+		{
+			next = now; // fell behind: no burst of catch-up samples
+		}
+		now = timer.WaitUntil(ovr_GetTimeInSeconds, next, m_IsTrackerRunning);
+		ThreadScheduling::RecordLatency(THREAD_TRACKER, now - next);
+		ThreadScheduling::Apply(THREAD_TRACKER);
+	}
+}
+
+unsigned __stdcall Oculus::TrackerThreadLauncher(void *obj)
+{
+	reinterpret_cast<Oculus*>(obj)->TrackerThread();
+	_endthreadex(0);
+	return 0;
+}
+
+void Oculus::SampleTracking()
+{
+	double now = ovr_GetTimeInSeconds();
+#if (OVR_PRODUCT_VERSION == 1) || (OVR_MAJOR_VERSION == 8)
+	ovrTrackingState trackingState = ovr_GetTrackingState(m_HmdSession, now, ovrFalse);
+#elif (OVR_MAJOR_VERSION == 7)
+	ovrTrackingState trackingState = ovr_GetTrackingState(m_HmdSession, now);
+#else
+	ovrTrackingState trackingState = ovrHmd_GetTrackingState(m_HmdSession, now);
+#endif
+	if (!(trackingState.StatusFlags & (ovrStatus_OrientationTracked | ovrStatus_PositionTracked)))
+	{
+		return;
+	}
+
+	OVR::Matrix4f navigationInverse = ToMatrix4f(GetLatchedNavigation(true));
+	PoseFrame poseFrame;
+	memset(&poseFrame, 0, sizeof(poseFrame));
+	poseFrame.Time = trackingState.HeadPose.TimeInSeconds;
+	poseFrame.TrackedDevices = (1u << POSE_HEAD);
+	ToCAVEPose(trackingState.HeadPose.ThePose, navigationInverse, false, poseFrame.Device[POSE_HEAD][0]);
+	ToCAVEPose(trackingState.HeadPose.ThePose, navigationInverse, true, poseFrame.Device[POSE_HEAD][1]);
+#if (OVR_PRODUCT_VERSION == 1)
+	if (m_CurrentControllerType == OCULUS_TOUCH_RIGHT)
+	{
+		for (int i = 0; i < ovrHand_Count; i++)
+		{
+			int device = (i == ovrHand_Left) ? POSE_LEFT_HAND : POSE_RIGHT_HAND;
+			if (trackingState.HandStatusFlags[i] & (ovrStatus_OrientationTracked | ovrStatus_PositionTracked))
+			{
+				poseFrame.TrackedDevices |= (1u << device);
+			}
+			ToCAVEPose(trackingState.HandPoses[i].ThePose, navigationInverse, false, poseFrame.Device[device][0]);
+			ToCAVEPose(trackingState.HandPoses[i].ThePose, navigationInverse, true, poseFrame.Device[device][1]);
+		}
+	}
+#endif
+	PublishPose(poseFrame);
+}
+
+void Oculus::PublishPose(const PoseFrame& frame)
+{
+	std::lock_guard<std::mutex> lock(m_PoseWriterMutex);
+	PoseFrame latest;
+	if (m_PoseHistory.Latest(latest) && (frame.Time <= latest.Time))
+	{
+		return; // the same sensor reading again (or an older one after a switch of the writer)
+	}
+	m_PoseHistory.Publish(frame);
+}
+
 bool Oculus::IsMainThread()
 {
 	if (GetCurrentThreadId() == m_MainThreadID)
@@ -1328,6 +2299,11 @@ bool Oculus::IsMainThread()
 	}
 }
 
+bool Oculus::IsTrackerThread()
+{
+	return m_IsTrackerRunning.load() && (GetCurrentThreadId() == m_TrackerThreadID.load());
+}
+
 bool Oculus::IsDisplayThread()
 {
 	if (GetCurrentThreadId() == m_DisplayThreadID)
@@ -31,7 +31,10 @@ const float FEET_PER_METER = 3.280840f;
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 #include <process.h>
 
@@ -56,6 +59,25 @@ const float FEET_PER_METER = 3.280840f;
 #include <Extras/OVR_Math.h>
 //#pragma comment(lib, "libovr.lib")
 
+#include "../../gl/loader.h"
+#include "../../gl/program_cache.h"
+#include "../../math/frustum.h"
+#include "../../math/lod.h"
+#include "../../math/navigation.h"
+#include "../../math/transform.h"
+#include "../../memory/frame_allocator.h"
+#include "../../memory/memory_stats.h"
+#include "../../thread/frame_task.h"
+#include "../../thread/job_graph.h"
+#include "../../thread/scheduling.h"
+#include "../../thread/startup_timer.h"
+#include "../../thread/thread_pool.h"
+#include "../../thread/wait_timer.h"
+#include "../../tracking/pose_history.h"
+#include "../../tracking/latency.h"
+#include "../../simulation/simulation.h"
+#include "../callback.h"
+
 #ifdef USE_OVRVISION
 #include "../../camera/ovrvision/ovrvision.h"
 #endif // USE_OVRVISION
@@ -65,11 +87,6 @@ const float FEET_PER_METER = 3.280840f;
 #endif // USE_ZEDMINI
 
 typedef void(*OVRCALLBACK)();
-typedef void(*OVRCALLBACK1)(void*);
-typedef void(*OVRCALLBACK2)(void*, void*);
-typedef void(*OVRCALLBACK3)(void*, void*, void*);
-typedef void(*OVRCALLBACK4)(void*, void*, void*, void*);
-typedef void(*OVRCALLBACK5)(void*, void*, void*, void*, void*);
 
 #if (OVR_PRODUCT_VERSION == 0)
 #define USE_MIRROR_WINDOW // Oculus SDK 0.5.0.1
@@ -81,6 +98,28 @@ typedef enum {
 	VECTOR_RIGHT
 } VECTOR_TYPE;
 
+typedef enum {
+	CALLBACK_INIT = 0,
+	CALLBACK_STOP,
+	CALLBACK_DRAW,
+	CALLBACK_IDLE,
+	CALLBACK_TYPE_COUNT
+} CALLBACK_TYPE;
+
+// maximum number of quad layers submitted next to the eye layer
+// (ovrMaxLayerCount is 16 including the eye layer)
+const int MAX_QUAD_LAYERS = 8;
+
+// upper limit of the tracker thread rate (Hz)
+const int MAX_TRACKER_RATE = 1000;
+
+typedef enum {
+	QUAD_LAYER_FREE = 0,
+	QUAD_LAYER_PENDING,  // requested by the app, swap chain not created yet
+	QUAD_LAYER_ACTIVE,
+	QUAD_LAYER_RELEASE   // released by the app, swap chain not destroyed yet
+} QUAD_LAYER_STATE;
+
 class Oculus {
 public:
 	Oculus();
@@ -92,14 +131,22 @@ public:
 	ovrSession hmdSession() { return m_HmdSession; } // for Oculus SDK 1.10.1
 #endif
 
-	void Init();
-	void InitGL();
+	bool Init();         // runtime session, any thread, false on failure
+	bool InitGLFW();     // false on failure
+	void InitGL();       // window and render context, after Init()
+	bool OpenCamera();   // any thread, false if a camera is not available
+	void InitCamera();   // camera textures, after InitGL() and OpenCamera()
 	void CreateBuffers();
 	void Terminate();
+	void DestroySession();
 	void UpdateTrackingData();
+	void StoreTrackingState(const ovrTrackingState& trackingState, bool hasHands); // hasHands: Oculus Touch
+	void UpdateLatencyStats();
+	void UpdateSimulation();
 	void PreProcess();
 	void PostProcess();
 	void SetMatrix(int eyeIndex);
+	void GetFrustum(int eyeIndex, bool navigated, float planes[6][4]); // eyeIndex == ovrEye_Count: both eyes
 	void Translate(float x, float y, float z);
 	void Rotate(float angle_degree, char axis);
 	void Scale(float x, float y, float z);
@@ -107,14 +154,38 @@ public:
 	void WorldRotate(float angle, char axis);
 	void WorldScale(float x, float y, float z);
 	OVR::Matrix4f GetNavigationMatrix();
+	void GetNavigationMatrix(double matrix[4][4]);
 	void LoadNavigationMatrix(OVR::Matrix4f matrix);
+	void LoadNavigationMatrix(const double matrix[4][4]);
 	void SetNavigationMatrixIdentity();
 	void SetNavigationMatrix();
 	void SetNavigationInverseMatrix();
+	void SetNavigationMatrixRelative(const double origin[3]);
 	void MultiNavigationMatrix(float matrix[4][4]);
 	void PreMultiNavigationMatrix(float matrix[4][4]);
-	void StoreNavigationMatrix() { m_NavigationMatrix_Backup = m_NavigationMatrix; }
-	void RestoreNavigationMatrix() { m_NavigationMatrix = m_NavigationMatrix_Backup; }
+	void StoreNavigationMatrix();
+	void RestoreNavigationMatrix();
+	void LockNavigation() { m_NavigationMutex.lock(); }     // CAVENavLock()
+	void UnlockNavigation() { m_NavigationMutex.unlock(); } // CAVENavUnlock()
+	Affine GetLatchedNavigation(bool inverse); // navigation of the current frame
+	const PoseHistory& poseHistory() const { return m_PoseHistory; }
+	double GetPredictedDisplayTime(int framesAhead); // framesAhead = 1 : the next frame
+	bool GetPredictedPose(int device, bool navigated, double time, Pose& pose);
+	void GetSensorFrame(SensorFrame& frame); // all sensors of the latest tracked frame
+	LatencyStats& latencyStats() { return m_LatencyStats; }
+	void StartSimulation(float rate, Callback callback); // empty callback: stop
+	FixedStepSimulation& simulation() { return m_Simulation; }
+	JobGraph& frameJobs() { return m_FrameJobs; } // joined at the end of each frame
+	FrameTaskScheduler& frameTasks() { return m_FrameTasks; }
+	int  CreateQuadLayer(int width, int height, bool headLocked);
+	void DestroyQuadLayer(int layerID);
+	void SetQuadLayerFunction(int layerID, Callback callback);
+	void SetQuadLayerPose(int layerID, float position[3], float angle[3], float size[2]);
+	void UpdateQuadLayer(int layerID);
+	int  EnqueueUpload(Callback callback);
+	bool IsUploadDone(int uploadID) { return m_ResourceLoader.IsDone(uploadID); }
+	void WaitUpload(int uploadID);
+	LodSelector& lodSelector() { return m_LodSelector; }
 	int  ShouldClose() const { return glfwWindowShouldClose(m_Window); }
 	void PollEvents() { glfwPollEvents(); }
 
@@ -136,7 +207,7 @@ public:
 
 #if (OVR_PRODUCT_VERSION == 1)
 	// for Oculus Touch
-	ControllerType controllerType() { return static_cast<ControllerType>(m_CurrentControllerType); }
+	ControllerType controllerType() { return static_cast<ControllerType>(m_CurrentControllerType.load()); }
 	void SwitchControllerType();
 	bool IsConnected(ControllerType type) { return m_IsConnected[type]; }
 	OVR::Vector3f handTranslation(ovrHandType handType) { return m_HandTranslation[handType]; }
@@ -151,31 +222,21 @@ public:
 	ovrSizei renderTargetSize() { return m_RenderTargetSize; }
 	ULONG64  frameIndex() { return m_FrameIndex; }
 
-	void StartThread();
+	void StartThread();  // returns once the display thread is started
+	bool WaitForInit();  // until the startup of the display thread is complete, false if it failed
+	bool IsInitialized() { return m_IsInitializedGLFW.load(); }
 	void StopThread();
 	bool IsMainThread();
 	bool IsDisplayThread();
+	bool IsTrackerThread();
+	void SetTrackerRate(int rate); // Hz, 0: no tracker thread
+	int  trackerRate() { return m_TrackerRate.load(); }
 
-	void SetInitFunction(OVRCALLBACK callback, std::vector<void*> arg_list)
-	{
-		p_InitFunction = callback;
-		m_InitFunctionArgs = arg_list;
-	}
-	void SetStopFunction(OVRCALLBACK callback, std::vector<void*> arg_list)
-	{
-		p_StopFunction = callback;
-		m_StopFunctionArgs = arg_list;
-	}
-	void SetDrawFunction(OVRCALLBACK callback, std::vector<void*> arg_list)
-	{
-		p_DrawFunction = callback;
-		m_DrawFunctionArgs = arg_list;
-	}
-	void SetIdleFunction(OVRCALLBACK callback, std::vector<void*> arg_list)
-	{
-		p_IdleFunction = callback;
-		m_IdleFunctionArgs = arg_list;
-	}
+	// any thread; the display thread takes the new callback at the start of a frame
+	void SetInitFunction(Callback callback) { SetCallback(CALLBACK_INIT, std::move(callback)); }
+	void SetStopFunction(Callback callback) { SetCallback(CALLBACK_STOP, std::move(callback)); }
+	void SetDrawFunction(Callback callback) { SetCallback(CALLBACK_DRAW, std::move(callback)); }
+	void SetIdleFunction(Callback callback) { SetCallback(CALLBACK_IDLE, std::move(callback)); }
 
 	bool GetKey(int);
 	int  GetMouseButton(int);
@@ -236,13 +297,24 @@ private:
 	OVR::Vector3f       m_BodyRotation[3];
 
 	int m_CurrentEyeIndex;
-	OVR::Matrix4f       m_NavigationMatrix;
-	OVR::Matrix4f       m_NavigationMatrix_Backup;
+	NavigationTransform m_Navigation;
+	NavigationTransform m_Navigation_Backup;
+	Affine              m_LatchedNavigation[2]; // navigation / inverse, latched in UpdateTrackingData()
+	std::recursive_mutex m_NavigationMutex; // guards the above, recursive for CAVENavLock()
+	PoseHistory         m_PoseHistory;
+	SensorFrame         m_SensorFrame;
+	std::mutex          m_SensorMutex;
+	LatencyStats        m_LatencyStats;
+	LatencyFrame        m_LatencyFrame;           // display thread only
+	FixedStepSimulation m_Simulation;
+	JobGraph            m_FrameJobs;
+	FrameTaskScheduler  m_FrameTasks;
 	OVR::Matrix4f       m_ModelMatrix;
+	long long           m_RenderTargetBytes;      // estimated, for MemoryStats
 
 #if (OVR_PRODUCT_VERSION == 1)
 	bool m_IsConnected[ENUM_CONTROLLER_TYPE_SIZE];
-	uint m_CurrentControllerType;                // Oculus Touch
+	std::atomic<uint> m_CurrentControllerType;   // Oculus Touch (read by the tracker thread)
 	OVR::Vector3f       m_HandTranslation[2];    // Oculus Touch
 	OVR::Vector3f       m_HandVector[2][3];      // Oculus Touch
 	OVR::Vector3f       m_HandTranslationNav[2]; // Oculus Touch
@@ -268,22 +340,71 @@ private:
 	bool                m_UseMirrorWindow;
 
 	bool                m_IsInitFunctionExecuted;
-	OVRCALLBACK         p_InitFunction;
-	OVRCALLBACK         p_StopFunction;
-	OVRCALLBACK         p_DrawFunction;
-	OVRCALLBACK         p_IdleFunction;
-	std::vector<void*>  m_InitFunctionArgs;
-	std::vector<void*>  m_StopFunctionArgs;
-	std::vector<void*>  m_DrawFunctionArgs;
-	std::vector<void*>  m_IdleFunctionArgs;
+	Callback            m_Callback[CALLBACK_TYPE_COUNT];        // called and destroyed by the display thread only
+	std::mutex          m_CallbackMutex;
+	Callback            m_PendingCallback[CALLBACK_TYPE_COUNT]; // under m_CallbackMutex
+	bool                m_IsCallbackPending[CALLBACK_TYPE_COUNT]; // under m_CallbackMutex
+	std::atomic<bool>   m_HasPendingCallback;
 
 	HANDLE m_HMutex;
 	HANDLE m_HRender;
 	bool   m_IsThreadRunning; // flag to stop the thread
 	std::atomic<bool>   m_IsInitializedGLFW;
+	std::mutex          m_InitMutex;
+	bool                m_IsInitFailed;       // under m_InitMutex
+	std::condition_variable m_InitCondition; // m_IsInitializedGLFW or m_IsInitFailed
+	StartupTimer        m_StartupTimer;
 	DWORD  m_MainThreadID;
 	DWORD  m_DisplayThreadID;
 
+	// tracker thread: samples the tracking into m_PoseHistory between frames
+	HANDLE              m_HTracker;
+	std::atomic<DWORD>  m_TrackerThreadID;
+	std::atomic<bool>   m_IsTrackerRunning;
+	std::atomic<int>    m_TrackerRate;
+	std::mutex          m_TrackerMutex;       // start / stop
+	std::mutex          m_PoseWriterMutex;    // writers of m_PoseHistory
+	void StartTracker();
+	void StopTracker();
+	void TrackerThread();
+	static unsigned __stdcall TrackerThreadLauncher(void *obj);
+	void SampleTracking();
+	void PublishPose(const PoseFrame& frame);
+
+	struct QuadLayer {
+		std::atomic<int>    State;
+		std::atomic<bool>   IsDirty;
+		bool                HasContent;   // true after the first redraw
+		bool                IsHeadLocked;
+		int                 Width;
+		int                 Height;
+		float               Position[3];  // CAVE coordinate (feet)
+		float               Angle[3];     // degrees, applied in Y-X-Z order
+		float               Size[2];      // CAVE coordinate (feet)
+		Callback            m_Function;
+#if (OVR_PRODUCT_VERSION == 1)
+		ovrTextureSwapChain m_SwapChain;
+		ovrLayerQuad        m_Layer;
+#endif
+	};
+	QuadLayer           m_QuadLayer[MAX_QUAD_LAYERS];
+	std::mutex          m_QuadLayerMutex;
+	GLuint              m_QuadLayerFBO;
+
+	void RenderQuadLayers();
+
+	ResourceLoader      m_ResourceLoader;
+
+	// view frustums of the current frame (physical / navigated, left / right / both eyes)
+	Frustum             m_Frustum[2][ovrEye_Count + 1];
+	std::mutex          m_FrustumMutex;
+
+	LodSelector         m_LodSelector;
+
+	OVR::Matrix4f EyeViewMatrix(int eyeIndex);
+	void UpdateFrustum();
+	void UpdateLOD();
+
 #ifdef USE_OVRVISION
 	OVRVision           m_OVRVision;
 #endif // USE_OVRVISION
@@ -315,135 +436,37 @@ private:
 	GLFWmonitor* CheckOVR();
 #endif
 
+	void SetCallback(int type, Callback callback);
+	void TakePendingCallbacks(); // display thread
+
 	void ExecInitCallback()
 	{
 		if (m_IsInitFunctionExecuted) return;
 
-		if (p_InitFunction != nullptr)
+		if (m_Callback[CALLBACK_INIT])
 		{
-			std::vector<void*> args = m_InitFunctionArgs;
-			switch (args.size())
-			{
-				case 0:
-					p_InitFunction();
-					break;
-				case 1:
-					((OVRCALLBACK1)p_InitFunction)(args[0]);
-					break;
-				case 2:
-					((OVRCALLBACK2)p_InitFunction)(args[0], args[1]);
-					break;
-				case 3:
-					((OVRCALLBACK3)p_InitFunction)(args[0], args[1], args[2]);
-					break;
-				case 4:
-					((OVRCALLBACK4)p_InitFunction)(args[0], args[1], args[2], args[3]);
-					break;
-				case 5:
-					((OVRCALLBACK5)p_InitFunction)(args[0], args[1], args[2], args[3], args[4]);
-					break;
-				default:
-					break;
-			}
+			m_Callback[CALLBACK_INIT]();
 			m_IsInitFunctionExecuted = true;
 		}
 	}
 
 	void ExecStopCallback()
 	{
-		if (p_StopFunction != nullptr)
-		{
-			std::vector<void*> args = m_StopFunctionArgs;
-			switch (args.size())
-			{
-				case 0:
-					p_StopFunction();
-					break;
-				case 1:
-					((OVRCALLBACK1)p_StopFunction)(args[0]);
-					break;
-				case 2:
-					((OVRCALLBACK2)p_StopFunction)(args[0], args[1]);
-					break;
-				case 3:
-					((OVRCALLBACK3)p_StopFunction)(args[0], args[1], args[2]);
-					break;
-				case 4:
-					((OVRCALLBACK4)p_StopFunction)(args[0], args[1], args[2], args[3]);
-					break;
-				case 5:
-					((OVRCALLBACK5)p_StopFunction)(args[0], args[1], args[2], args[3], args[4]);
-					break;
-				default:
-					break;
-			}
-		}
+		m_Callback[CALLBACK_STOP]();
 	}
 
 	void ExecDrawCallback()
 	{
 		if (!m_IsInitFunctionExecuted) return;
 
-		if (p_DrawFunction != nullptr)
-		{
-			std::vector<void*> args = m_DrawFunctionArgs;
-			switch (args.size())
-			{
-				case 0:
-					p_DrawFunction();
-					break;
-				case 1:
-					((OVRCALLBACK1)p_DrawFunction)(args[0]);
-					break;
-				case 2:
-					((OVRCALLBACK2)p_DrawFunction)(args[0], args[1]);
-					break;
-				case 3:
-					((OVRCALLBACK3)p_DrawFunction)(args[0], args[1], args[2]);
-					break;
-				case 4:
-					((OVRCALLBACK4)p_DrawFunction)(args[0], args[1], args[2], args[3]);
-					break;
-				case 5:
-					((OVRCALLBACK5)p_DrawFunction)(args[0], args[1], args[2], args[3], args[4]);
-					break;
-				default:
-					break;
-			}
-		}
+		m_Callback[CALLBACK_DRAW]();
 	}
 
 	void ExecIdleCallback()
 	{
 		if (!m_IsInitFunctionExecuted) return;
 
-		if (p_IdleFunction != nullptr)
-		{
-			std::vector<void*> args = m_IdleFunctionArgs;
-			switch (args.size())
-			{
-				case 0:
-					p_IdleFunction();
-					break;
-				case 1:
-					((OVRCALLBACK1)p_IdleFunction)(args[0]);
-					break;
-				case 2:
-					((OVRCALLBACK2)p_IdleFunction)(args[0], args[1]);
-					break;
-				case 3:
-					((OVRCALLBACK3)p_IdleFunction)(args[0], args[1], args[2]);
-					break;
-				case 4:
-					((OVRCALLBACK4)p_IdleFunction)(args[0], args[1], args[2], args[3]);
-					break;
-				case 5:
-					((OVRCALLBACK5)p_IdleFunction)(args[0], args[1], args[2], args[3], args[4]);
-					break;
-				default:
-					break;
-			}
-		}
+		m_Callback[CALLBACK_IDLE]();
 	}
 
 	void MainThreadEX();
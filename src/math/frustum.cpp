@@ -0,0 +1,309 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// frustum.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "frustum.h"
+#include "../thread/thread_pool.h"
+
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX__)
+#define USE_CULL_AVX
+#include <immintrin.h>
+#elif defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+#define USE_CULL_SSE
+#include <emmintrin.h>
+#endif
+
+void Frustum::SetFromMatrix(const float m[4][4])
+{
+	for (int i = 0; i < 4; i++)
+	{
+		Plane[FRUSTUM_LEFT  ][i] = m[3][i] + m[0][i];
+		Plane[FRUSTUM_RIGHT ][i] = m[3][i] - m[0][i];
+		Plane[FRUSTUM_BOTTOM][i] = m[3][i] + m[1][i];
+		Plane[FRUSTUM_TOP   ][i] = m[3][i] - m[1][i];
+		Plane[FRUSTUM_NEAR  ][i] = m[3][i] + m[2][i];
+		Plane[FRUSTUM_FAR   ][i] = m[3][i] - m[2][i];
+	}
+
+	for (int j = 0; j < FRUSTUM_PLANE_COUNT; j++)
+	{
+		float length = sqrtf(
+			Plane[j][0] * Plane[j][0] +
+			Plane[j][1] * Plane[j][1] +
+			Plane[j][2] * Plane[j][2]);
+		if (length > 0.0f)
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				Plane[j][i] /= length;
+			}
+		}
+	}
+}
+
+void Frustum::SetStereo(const Frustum& leftEye, const Frustum& rightEye)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		Plane[FRUSTUM_LEFT ][i] = leftEye.Plane[FRUSTUM_LEFT][i];
+		Plane[FRUSTUM_RIGHT][i] = rightEye.Plane[FRUSTUM_RIGHT][i];
+	}
+
+	// both eyes share the orientation of the head, so these planes only
+	// differ in their distance
+	for (int j = FRUSTUM_BOTTOM; j < FRUSTUM_PLANE_COUNT; j++)
+	{
+		const float *plane =
+			(leftEye.Plane[j][3] > rightEye.Plane[j][3]) ? leftEye.Plane[j] : rightEye.Plane[j];
+		for (int i = 0; i < 4; i++)
+		{
+			Plane[j][i] = plane[i];
+		}
+	}
+}
+
+namespace
+{
+	int CullSpheresScalar(const float planes[6][4], const float *spheres, int begin, int end, unsigned char *visible)
+	{
+		int numVisible = 0;
+		for (int n = begin; n < end; n++)
+		{
+			const float *s = &spheres[n * 4];
+			unsigned char inside = 1;
+			for (int j = 0; j < FRUSTUM_PLANE_COUNT; j++)
+			{
+				float distance = planes[j][0] * s[0] + planes[j][1] * s[1] + planes[j][2] * s[2] + planes[j][3];
+				if (distance < -s[3])
+				{
+					inside = 0;
+					break;
+				}
+			}
+			visible[n] = inside;
+			numVisible += inside;
+		}
+		return numVisible;
+	}
+
+	int CullBoxesScalar(const float planes[6][4], const float *boxes, int begin, int end, unsigned char *visible)
+	{
+		int numVisible = 0;
+		for (int n = begin; n < end; n++)
+		{
+			const float *b = &boxes[n * 6];
+			unsigned char inside = 1;
+			for (int j = 0; j < FRUSTUM_PLANE_COUNT; j++)
+			{
+				// the corner farthest along the plane normal
+				float x = (planes[j][0] >= 0.0f) ? b[3] : b[0];
+				float y = (planes[j][1] >= 0.0f) ? b[4] : b[1];
+				float z = (planes[j][2] >= 0.0f) ? b[5] : b[2];
+				if (planes[j][0] * x + planes[j][1] * y + planes[j][2] * z + planes[j][3] < 0.0f)
+				{
+					inside = 0;
+					break;
+				}
+			}
+			visible[n] = inside;
+			numVisible += inside;
+		}
+		return numVisible;
+	}
+
+#if defined(USE_CULL_AVX)
+	const int CULL_SIMD_WIDTH = 8;
+
+	inline __m256 Combine(__m128 lo, __m128 hi)
+	{
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+	}
+
+	inline int StoreMask(int mask, unsigned char *visible)
+	{
+		int numVisible = 0;
+		for (int i = 0; i < CULL_SIMD_WIDTH; i++)
+		{
+			visible[i] = static_cast<unsigned char>((mask >> i) & 1);
+			numVisible += visible[i];
+		}
+		return numVisible;
+	}
+
+	int CullSpheresSIMD(const float planes[6][4], const float *spheres, int begin, int end, unsigned char *visible)
+	{
+		int numVisible = 0;
+		int n = begin;
+		for (; n + CULL_SIMD_WIDTH <= end; n += CULL_SIMD_WIDTH)
+		{
+			// AoS (x, y, z, r) x 8 -> SoA
+			const float *s = &spheres[n * 4];
+			__m128 r0 = _mm_loadu_ps(s +  0), r1 = _mm_loadu_ps(s +  4), r2 = _mm_loadu_ps(s +  8), r3 = _mm_loadu_ps(s + 12);
+			__m128 r4 = _mm_loadu_ps(s + 16), r5 = _mm_loadu_ps(s + 20), r6 = _mm_loadu_ps(s + 24), r7 = _mm_loadu_ps(s + 28);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_MM_TRANSPOSE4_PS(r4, r5, r6, r7);
+			__m256 x = Combine(r0, r4), y = Combine(r1, r5), z = Combine(r2, r6), negR = _mm256_sub_ps(_mm256_setzero_ps(), Combine(r3, r7));
+
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (int j = 0; j < FRUSTUM_PLANE_COUNT; j++)
+			{
+				__m256 d = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(planes[j][0])), _mm256_mul_ps(y, _mm256_set1_ps(planes[j][1]))),
+					_mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(planes[j][2])), _mm256_set1_ps(planes[j][3])));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negR, _CMP_GE_OQ));
+			}
+			numVisible += StoreMask(_mm256_movemask_ps(inside), &visible[n]);
+		}
+		return numVisible + CullSpheresScalar(planes, spheres, n, end, visible);
+	}
+
+	int CullBoxesSIMD(const float planes[6][4], const float *boxes, int begin, int end, unsigned char *visible)
+	{
+		int numVisible = 0;
+		int n = begin;
+		for (; n + CULL_SIMD_WIDTH <= end; n += CULL_SIMD_WIDTH)
+		{
+			const float *b = &boxes[n * 6];
+			__m256 minX = _mm256_set_ps(b[42], b[36], b[30], b[24], b[18], b[12], b[6], b[0]);
+			__m256 minY = _mm256_set_ps(b[43], b[37], b[31], b[25], b[19], b[13], b[7], b[1]);
+			__m256 minZ = _mm256_set_ps(b[44], b[38], b[32], b[26], b[20], b[14], b[8], b[2]);
+			__m256 maxX = _mm256_set_ps(b[45], b[39], b[33], b[27], b[21], b[15], b[9], b[3]);
+			__m256 maxY = _mm256_set_ps(b[46], b[40], b[34], b[28], b[22], b[16], b[10], b[4]);
+			__m256 maxZ = _mm256_set_ps(b[47], b[41], b[35], b[29], b[23], b[17], b[11], b[5]);
+
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (int j = 0; j < FRUSTUM_PLANE_COUNT; j++)
+			{
+				__m256 x = (planes[j][0] >= 0.0f) ? maxX : minX;
+				__m256 y = (planes[j][1] >= 0.0f) ? maxY : minY;
+				__m256 z = (planes[j][2] >= 0.0f) ? maxZ : minZ;
+				__m256 d = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(planes[j][0])), _mm256_mul_ps(y, _mm256_set1_ps(planes[j][1]))),
+					_mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(planes[j][2])), _mm256_set1_ps(planes[j][3])));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GE_OQ));
+			}
+			numVisible += StoreMask(_mm256_movemask_ps(inside), &visible[n]);
+		}
+		return numVisible + CullBoxesScalar(planes, boxes, n, end, visible);
+	}
+#elif defined(USE_CULL_SSE)
+	const int CULL_SIMD_WIDTH = 4;
+
+	inline int StoreMask(int mask, unsigned char *visible)
+	{
+		int numVisible = 0;
+		for (int i = 0; i < CULL_SIMD_WIDTH; i++)
+		{
+			visible[i] = static_cast<unsigned char>((mask >> i) & 1);
+			numVisible += visible[i];
+		}
+		return numVisible;
+	}
+
+	int CullSpheresSIMD(const float planes[6][4], const float *spheres, int begin, int end, unsigned char *visible)
+	{
+		int numVisible = 0;
+		int n = begin;
+		for (; n + CULL_SIMD_WIDTH <= end; n += CULL_SIMD_WIDTH)
+		{
+			// AoS (x, y, z, r) x 4 -> SoA
+			const float *s = &spheres[n * 4];
+			__m128 x = _mm_loadu_ps(s), y = _mm_loadu_ps(s + 4), z = _mm_loadu_ps(s + 8), r = _mm_loadu_ps(s + 12);
+			_MM_TRANSPOSE4_PS(x, y, z, r);
+			__m128 negR = _mm_sub_ps(_mm_setzero_ps(), r);
+
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int j = 0; j < FRUSTUM_PLANE_COUNT; j++)
+			{
+				__m128 d = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(planes[j][0])), _mm_mul_ps(y, _mm_set1_ps(planes[j][1]))),
+					_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(planes[j][2])), _mm_set1_ps(planes[j][3])));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negR));
+			}
+			numVisible += StoreMask(_mm_movemask_ps(inside), &visible[n]);
+		}
+		return numVisible + CullSpheresScalar(planes, spheres, n, end, visible);
+	}
+
+	int CullBoxesSIMD(const float planes[6][4], const float *boxes, int begin, int end, unsigned char *visible)
+	{
+		int numVisible = 0;
+		int n = begin;
+		for (; n + CULL_SIMD_WIDTH <= end; n += CULL_SIMD_WIDTH)
+		{
+			const float *b = &boxes[n * 6];
+			__m128 minX = _mm_set_ps(b[18], b[12], b[6], b[0]);
+			__m128 minY = _mm_set_ps(b[19], b[13], b[7], b[1]);
+			__m128 minZ = _mm_set_ps(b[20], b[14], b[8], b[2]);
+			__m128 maxX = _mm_set_ps(b[21], b[15], b[9], b[3]);
+			__m128 maxY = _mm_set_ps(b[22], b[16], b[10], b[4]);
+			__m128 maxZ = _mm_set_ps(b[23], b[17], b[11], b[5]);
+
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int j = 0; j < FRUSTUM_PLANE_COUNT; j++)
+			{
+				__m128 x = (planes[j][0] >= 0.0f) ? maxX : minX;
+				__m128 y = (planes[j][1] >= 0.0f) ? maxY : minY;
+				__m128 z = (planes[j][2] >= 0.0f) ? maxZ : minZ;
+				__m128 d = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(planes[j][0])), _mm_mul_ps(y, _mm_set1_ps(planes[j][1]))),
+					_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(planes[j][2])), _mm_set1_ps(planes[j][3])));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(d, _mm_setzero_ps()));
+			}
+			numVisible += StoreMask(_mm_movemask_ps(inside), &visible[n]);
+		}
+		return numVisible + CullBoxesScalar(planes, boxes, n, end, visible);
+	}
+#else
+	int CullSpheresSIMD(const float planes[6][4], const float *spheres, int begin, int end, unsigned char *visible)
+	{
+		return CullSpheresScalar(planes, spheres, begin, end, visible);
+	}
+
+	int CullBoxesSIMD(const float planes[6][4], const float *boxes, int begin, int end, unsigned char *visible)
+	{
+		return CullBoxesScalar(planes, boxes, begin, end, visible);
+	}
+#endif
+
+	typedef int (*CULLFUNCTION)(const float planes[6][4], const float *data, int begin, int end, unsigned char *visible);
+
+	int CullParallel(CULLFUNCTION function, const float planes[6][4], const float *data, int count, unsigned char *visible, int numThreads)
+	{
+		if ((numThreads <= 1) || (count < CULL_PARALLEL_THRESHOLD))
+		{
+			return function(planes, data, 0, count, visible);
+		}
+
+		numThreads = std::min(numThreads, count / (CULL_PARALLEL_THRESHOLD / 4));
+		// chunks are multiples of 64 so that no two threads write the same cache line
+		int chunk = ((count + numThreads - 1) / numThreads + 63) & ~63;
+		std::atomic<int> total(0);
+		ThreadPool::Instance().ParallelFor(0, count, chunk,
+			[=, &total](int begin, int end) { total.fetch_add(function(planes, data, begin, end, visible)); }, numThreads);
+		return total.load();
+	}
+}
+
+int CullSpheres(const float planes[6][4], const float *spheres, int count, unsigned char *visible, int numThreads)
+{
+	return CullParallel(CullSpheresSIMD, planes, spheres, count, visible, numThreads);
+}
+
+int CullBoxes(const float planes[6][4], const float *boxes, int count, unsigned char *visible, int numThreads)
+{
+	return CullParallel(CullBoxesSIMD, planes, boxes, count, visible, numThreads);
+}
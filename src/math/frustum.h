@@ -0,0 +1,48 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// frustum.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+typedef enum {
+	FRUSTUM_LEFT = 0,
+	FRUSTUM_RIGHT,
+	FRUSTUM_BOTTOM,
+	FRUSTUM_TOP,
+	FRUSTUM_NEAR,
+	FRUSTUM_FAR,
+	FRUSTUM_PLANE_COUNT
+} FRUSTUM_PLANE;
+
+// Six planes (a, b, c, d) with unit normals pointing inside the frustum,
+// i.e. a point p is inside when a * p.x + b * p.y + c * p.z + d >= 0.
+struct Frustum
+{
+	float Plane[FRUSTUM_PLANE_COUNT][4];
+
+	// extract the planes from a clip matrix (clip = m * p, m[row][column])
+	void SetFromMatrix(const float m[4][4]);
+
+	// frustum enclosing both eyes: the outer side planes of each eye and
+	// the more permissive of the remaining (nearly parallel) planes
+	void SetStereo(const Frustum& leftEye, const Frustum& rightEye);
+};
+
+// Batch culling. spheres: count * (x, y, z, radius),
+// boxes: count * (min x, min y, min z, max x, max y, max z).
+// visible[i] is set to 1 if the object intersects the frustum, otherwise 0.
+// Returns the number of visible objects.
+// numThreads > 1 splits batches larger than CULL_PARALLEL_THRESHOLD.
+const int CULL_PARALLEL_THRESHOLD = 16384;
+
+int CullSpheres(const float planes[6][4], const float *spheres, int count, unsigned char *visible, int numThreads = 1);
+int CullBoxes(const float planes[6][4], const float *boxes, int count, unsigned char *visible, int numThreads = 1);
@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// lod.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lod.h"
+
+#include <cmath>
+#include <queue>
+#include <algorithm>
+
+namespace
+{
+	const float MIN_DISTANCE = 1.0e-3f;
+}
+
+LodSelector::LodSelector()
+	: m_PixelError(1.0f)
+	, m_Hysteresis(0.2f)
+	, m_TriangleBudget(0)
+	, m_TriangleCount(0)
+{
+}
+
+int LodSelector::Register(const float center[3], float radius, int numLevels, const float *error, const int *triangles, bool navigated)
+{
+	if (numLevels < 1)
+	{
+		return -1;
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	int objectID = 0;
+	while ((objectID < static_cast<int>(m_Objects.size())) && m_Objects[objectID].IsUsed)
+	{
+		objectID++;
+	}
+	if (objectID == static_cast<int>(m_Objects.size()))
+	{
+		m_Objects.push_back(LodObject());
+	}
+
+	LodObject& object = m_Objects[objectID];
+	object.IsUsed = true;
+	object.IsNavigated = navigated;
+	object.Center[0] = center[0];
+	object.Center[1] = center[1];
+	object.Center[2] = center[2];
+	object.Radius = radius;
+	object.Error.assign(error, error + numLevels);
+	object.Triangles.assign(numLevels, 0);
+	if (triangles != nullptr)
+	{
+		object.Triangles.assign(triangles, triangles + numLevels);
+	}
+	object.Level = -1;
+	object.LastLevel = numLevels - 1;
+	object.ErrorScale = 0.0f;
+
+	return objectID;
+}
+
+void LodSelector::Unregister(int objectID)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if ((objectID >= 0) && (objectID < static_cast<int>(m_Objects.size())))
+	{
+		m_Objects[objectID].IsUsed = false;
+		m_Objects[objectID].Level = -1;
+	}
+}
+
+void LodSelector::SetBounds(int objectID, const float center[3], float radius)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if ((objectID >= 0) && (objectID < static_cast<int>(m_Objects.size())))
+	{
+		LodObject& object = m_Objects[objectID];
+		object.Center[0] = center[0];
+		object.Center[1] = center[1];
+		object.Center[2] = center[2];
+		object.Radius = radius;
+	}
+}
+
+void LodSelector::SetOptions(float pixelError, float hysteresis, long long triangleBudget)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_PixelError = std::max(pixelError, 1.0e-3f);
+	m_Hysteresis = std::min(std::max(hysteresis, 0.0f), 0.9f);
+	m_TriangleBudget = std::max(triangleBudget, 0LL);
+}
+
+void LodSelector::Select(const LodView& view, const LodView& navigatedView)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_TriangleCount = 0;
+	for (auto& object : m_Objects)
+	{
+		if (object.IsUsed)
+		{
+			SelectLevel(object, object.IsNavigated ? navigatedView : view);
+			if (object.Level >= 0)
+			{
+				m_TriangleCount += object.Triangles[object.Level];
+			}
+		}
+	}
+
+	if ((m_TriangleBudget > 0) && (m_TriangleCount > m_TriangleBudget))
+	{
+		ApplyBudget();
+	}
+
+	for (auto& object : m_Objects)
+	{
+		if (object.IsUsed && (object.Level >= 0))
+		{
+			object.LastLevel = object.Level;
+		}
+	}
+}
+
+void LodSelector::SelectLevel(LodObject& object, const LodView& view)
+{
+	unsigned char visible;
+	float sphere[4] = { object.Center[0], object.Center[1], object.Center[2], object.Radius };
+	if (CullSpheres(view.View.Plane, sphere, 1, &visible) == 0)
+	{
+		object.Level = -1;
+		return;
+	}
+
+	// the nearer eye gives the larger projected error
+	float distance = 0.0f;
+	for (int eyeIndex = 0; eyeIndex < 2; eyeIndex++)
+	{
+		float dx = object.Center[0] - view.EyePosition[eyeIndex][0];
+		float dy = object.Center[1] - view.EyePosition[eyeIndex][1];
+		float dz = object.Center[2] - view.EyePosition[eyeIndex][2];
+		float d = sqrtf(dx * dx + dy * dy + dz * dz);
+		distance = (eyeIndex == 0) ? d : std::min(distance, d);
+	}
+	distance = std::max(distance - object.Radius, MIN_DISTANCE);
+	object.ErrorScale = view.PixelScale / distance;
+
+	// the coarsest level within the threshold; a coarser level than the last
+	// one must also be within the threshold lowered by the hysteresis
+	int numLevels = static_cast<int>(object.Error.size());
+	int level = 0;
+	for (int i = numLevels - 1; i > 0; i--)
+	{
+		float threshold = (i > object.LastLevel) ? m_PixelError * (1.0f - m_Hysteresis) : m_PixelError;
+		if (object.Error[i] * object.ErrorScale <= threshold)
+		{
+			level = i;
+			break;
+		}
+	}
+	object.Level = level;
+}
+
+void LodSelector::ApplyBudget()
+{
+	// coarsen the object whose next level adds the smallest projected error
+	// until the selection fits into the budget
+	typedef std::pair<float, int> Candidate;
+	std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> candidates;
+	for (int i = 0; i < static_cast<int>(m_Objects.size()); i++)
+	{
+		const LodObject& object = m_Objects[i];
+		if (object.IsUsed && (object.Level >= 0) && (object.Level + 1 < static_cast<int>(object.Error.size())))
+		{
+			candidates.push(Candidate(object.Error[object.Level + 1] * object.ErrorScale, i));
+		}
+	}
+
+	while ((m_TriangleCount > m_TriangleBudget) && !candidates.empty())
+	{
+		int objectID = candidates.top().second;
+		LodObject& object = m_Objects[objectID];
+		candidates.pop();
+
+		m_TriangleCount -= object.Triangles[object.Level] - object.Triangles[object.Level + 1];
+		object.Level++;
+		if (object.Level + 1 < static_cast<int>(object.Error.size()))
+		{
+			candidates.push(Candidate(object.Error[object.Level + 1] * object.ErrorScale, objectID));
+		}
+	}
+}
+
+int LodSelector::GetLevels(int *levels, int maxCount)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	int count = std::min(maxCount, static_cast<int>(m_Objects.size()));
+	for (int i = 0; i < count; i++)
+	{
+		levels[i] = m_Objects[i].IsUsed ? m_Objects[i].Level : -1;
+	}
+	return static_cast<int>(m_Objects.size());
+}
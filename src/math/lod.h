@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// lod.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <mutex>
+
+#include "frustum.h"
+
+// view parameters of one coordinate system (CAVE or navigated)
+struct LodView
+{
+	float   EyePosition[2][3];
+	float   PixelScale;  // pixels per unit at distance 1 (viewport height * P[1][1] / 2)
+	Frustum View;        // frustum enclosing both eyes
+};
+
+// Screen-space-error LOD selection.
+// Levels are ordered from the finest (0) to the coarsest, and the geometric
+// error of each level is given in the units of its coordinate system.
+class LodSelector
+{
+public:
+	LodSelector();
+
+	int  Register(const float center[3], float radius, int numLevels, const float *error, const int *triangles, bool navigated);
+	void Unregister(int objectID);
+	void SetBounds(int objectID, const float center[3], float radius);
+	void SetOptions(float pixelError, float hysteresis, long long triangleBudget);
+
+	// called once per frame by the display thread
+	void Select(const LodView& view, const LodView& navigatedView);
+
+	// levels[objectID] (-1: culled or unused), returns the number of object IDs
+	int  GetLevels(int *levels, int maxCount);
+	long long triangleCount() { return m_TriangleCount; }
+
+private:
+	struct LodObject
+	{
+		bool               IsUsed;
+		bool               IsNavigated;
+		float              Center[3];
+		float              Radius;
+		std::vector<float> Error;
+		std::vector<int>   Triangles;
+		int                Level;     // selected level, -1 if culled
+		int                LastLevel; // last level while visible, for hysteresis
+		float              ErrorScale; // pixel error per unit of geometric error
+	};
+
+	std::vector<LodObject> m_Objects;
+	std::mutex             m_Mutex;
+	float                  m_PixelError;
+	float                  m_Hysteresis;
+	long long              m_TriangleBudget; // 0: unlimited
+	long long              m_TriangleCount;
+
+	void SelectLevel(LodObject& object, const LodView& view);
+	void ApplyBudget();
+};
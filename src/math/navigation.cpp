@@ -0,0 +1,296 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// navigation.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "navigation.h"
+
+#include <cmath>
+#include <cctype>
+
+namespace
+{
+	// rows/columns (i, j) mixed by a rotation about the axis
+	bool RotationAxes(char axis, int& i, int& j)
+	{
+		switch (tolower(axis))
+		{
+			case 'x':
+				i = 1; j = 2;
+				return true;
+			case 'y':
+				i = 2; j = 0;
+				return true;
+			case 'z':
+				i = 0; j = 1;
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	template <typename T>
+	void FromMatrix(const T m[4][4], Affine& a)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			a.Linear[i][0] = m[i][0];
+			a.Linear[i][1] = m[i][1];
+			a.Linear[i][2] = m[i][2];
+			a.Translation[i] = m[i][3];
+		}
+	}
+
+	template <typename T>
+	void ToMatrix(const Affine& a, T m[4][4])
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			m[i][0] = static_cast<T>(a.Linear[i][0]);
+			m[i][1] = static_cast<T>(a.Linear[i][1]);
+			m[i][2] = static_cast<T>(a.Linear[i][2]);
+			m[i][3] = static_cast<T>(a.Translation[i]);
+		}
+		m[3][0] = 0;
+		m[3][1] = 0;
+		m[3][2] = 0;
+		m[3][3] = 1;
+	}
+}
+
+void AffineFromMatrix(const float m[4][4], Affine& a)
+{
+	FromMatrix(m, a);
+}
+
+void AffineFromMatrix(const double m[4][4], Affine& a)
+{
+	FromMatrix(m, a);
+}
+
+void AffineToMatrix(const Affine& a, float m[4][4])
+{
+	ToMatrix(a, m);
+}
+
+void AffineToMatrix(const Affine& a, double m[4][4])
+{
+	ToMatrix(a, m);
+}
+
+void AffineMultiply(const Affine& a, const Affine& b, Affine& result)
+{
+	Affine c;
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			c.Linear[i][j] = a.Linear[i][0] * b.Linear[0][j] + a.Linear[i][1] * b.Linear[1][j] + a.Linear[i][2] * b.Linear[2][j];
+		}
+		c.Translation[i] = a.Linear[i][0] * b.Translation[0] + a.Linear[i][1] * b.Translation[1] + a.Linear[i][2] * b.Translation[2] + a.Translation[i];
+	}
+	result = c;
+}
+
+NavigationTransform::NavigationTransform()
+{
+	SetIdentity();
+}
+
+void NavigationTransform::SetIdentity()
+{
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			m_Transform.Linear[i][j] = (i == j) ? 1.0 : 0.0;
+		}
+		m_Transform.Translation[i] = 0.0;
+	}
+	m_Inverse = m_Transform;
+	m_IsInverseValid = true;
+}
+
+void NavigationTransform::Load(const float m[4][4])
+{
+	AffineFromMatrix(m, m_Transform);
+	m_IsInverseValid = false;
+}
+
+void NavigationTransform::Load(const double m[4][4])
+{
+	AffineFromMatrix(m, m_Transform);
+	m_IsInverseValid = false;
+}
+
+void NavigationTransform::GetMatrix(float m[4][4]) const
+{
+	AffineToMatrix(m_Transform, m);
+}
+
+void NavigationTransform::GetMatrix(double m[4][4]) const
+{
+	AffineToMatrix(m_Transform, m);
+}
+
+void NavigationTransform::GetInverseMatrix(float m[4][4])
+{
+	AffineToMatrix(inverse(), m);
+}
+
+void NavigationTransform::GetInverseMatrix(double m[4][4])
+{
+	AffineToMatrix(inverse(), m);
+}
+
+void NavigationTransform::PreTranslate(double x, double y, double z)
+{
+	m_Transform.Translation[0] += x;
+	m_Transform.Translation[1] += y;
+	m_Transform.Translation[2] += z;
+	m_IsInverseValid = false;
+}
+
+void NavigationTransform::PreRotate(double angle_radian, char axis)
+{
+	int i, j;
+	if (!RotationAxes(axis, i, j))
+	{
+		return;
+	}
+
+	double c = cos(angle_radian);
+	double s = sin(angle_radian);
+	for (int k = 0; k < 3; k++)
+	{
+		double a = m_Transform.Linear[i][k];
+		double b = m_Transform.Linear[j][k];
+		m_Transform.Linear[i][k] = c * a - s * b;
+		m_Transform.Linear[j][k] = s * a + c * b;
+	}
+	double a = m_Transform.Translation[i];
+	double b = m_Transform.Translation[j];
+	m_Transform.Translation[i] = c * a - s * b;
+	m_Transform.Translation[j] = s * a + c * b;
+	m_IsInverseValid = false;
+}
+
+void NavigationTransform::PreScale(double x, double y, double z)
+{
+	const double scale[3] = { x, y, z };
+	for (int i = 0; i < 3; i++)
+	{
+		m_Transform.Linear[i][0] *= scale[i];
+		m_Transform.Linear[i][1] *= scale[i];
+		m_Transform.Linear[i][2] *= scale[i];
+		m_Transform.Translation[i] *= scale[i];
+	}
+	m_IsInverseValid = false;
+}
+
+void NavigationTransform::PreMultiply(const float m[4][4])
+{
+	Affine a;
+	AffineFromMatrix(m, a);
+	AffineMultiply(a, m_Transform, m_Transform);
+	m_IsInverseValid = false;
+}
+
+void NavigationTransform::PostTranslate(double x, double y, double z)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		m_Transform.Translation[i] += m_Transform.Linear[i][0] * x + m_Transform.Linear[i][1] * y + m_Transform.Linear[i][2] * z;
+	}
+	m_IsInverseValid = false;
+}
+
+void NavigationTransform::PostRotate(double angle_radian, char axis)
+{
+	int i, j;
+	if (!RotationAxes(axis, i, j))
+	{
+		return;
+	}
+
+	double c = cos(angle_radian);
+	double s = sin(angle_radian);
+	for (int k = 0; k < 3; k++)
+	{
+		double a = m_Transform.Linear[k][i];
+		double b = m_Transform.Linear[k][j];
+		m_Transform.Linear[k][i] = c * a + s * b;
+		m_Transform.Linear[k][j] = c * b - s * a;
+	}
+	m_IsInverseValid = false;
+}
+
+void NavigationTransform::PostScale(double x, double y, double z)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		m_Transform.Linear[i][0] *= x;
+		m_Transform.Linear[i][1] *= y;
+		m_Transform.Linear[i][2] *= z;
+	}
+	m_IsInverseValid = false;
+}
+
+void NavigationTransform::PostMultiply(const float m[4][4])
+{
+	Affine a;
+	AffineFromMatrix(m, a);
+	AffineMultiply(m_Transform, a, m_Transform);
+	m_IsInverseValid = false;
+}
+
+const Affine& NavigationTransform::inverse()
+{
+	if (!m_IsInverseValid)
+	{
+		UpdateInverse();
+	}
+	return m_Inverse;
+}
+
+void NavigationTransform::UpdateInverse()
+{
+	const double (*l)[3] = m_Transform.Linear;
+	Affine& inv = m_Inverse;
+
+	// adjugate / determinant
+	inv.Linear[0][0] = l[1][1] * l[2][2] - l[1][2] * l[2][1];
+	inv.Linear[0][1] = l[0][2] * l[2][1] - l[0][1] * l[2][2];
+	inv.Linear[0][2] = l[0][1] * l[1][2] - l[0][2] * l[1][1];
+	inv.Linear[1][0] = l[1][2] * l[2][0] - l[1][0] * l[2][2];
+	inv.Linear[1][1] = l[0][0] * l[2][2] - l[0][2] * l[2][0];
+	inv.Linear[1][2] = l[0][2] * l[1][0] - l[0][0] * l[1][2];
+	inv.Linear[2][0] = l[1][0] * l[2][1] - l[1][1] * l[2][0];
+	inv.Linear[2][1] = l[0][1] * l[2][0] - l[0][0] * l[2][1];
+	inv.Linear[2][2] = l[0][0] * l[1][1] - l[0][1] * l[1][0];
+	double det = l[0][0] * inv.Linear[0][0] + l[0][1] * inv.Linear[1][0] + l[0][2] * inv.Linear[2][0];
+	double invDet = (det != 0.0) ? 1.0 / det : 0.0;
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			inv.Linear[i][j] *= invDet;
+		}
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		inv.Translation[i] = -(inv.Linear[i][0] * m_Transform.Translation[0] +
+		                       inv.Linear[i][1] * m_Transform.Translation[1] +
+		                       inv.Linear[i][2] * m_Transform.Translation[2]);
+	}
+	m_IsInverseValid = true;
+}
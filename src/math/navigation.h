@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// navigation.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// p' = Linear * p + Translation
+// Double precision, so that navigation far from the origin does not jitter.
+struct Affine
+{
+	double Linear[3][3];
+	double Translation[3];
+};
+
+// Navigation matrix kept as an affine transform (rotation and scaling in
+// Linear). The inverse is computed in closed form when it is first needed
+// after a change and cached until the next change.
+// Matrices are m[row][column] and transform column vectors (as OVR::Matrix4f).
+class NavigationTransform
+{
+public:
+	NavigationTransform();
+
+	void SetIdentity();
+	void Load(const float m[4][4]); // the projective row is ignored
+	void Load(const double m[4][4]);
+	void GetMatrix(float m[4][4]) const;
+	void GetMatrix(double m[4][4]) const;
+	void GetInverseMatrix(float m[4][4]);
+	void GetInverseMatrix(double m[4][4]);
+
+	// N = A * N
+	void PreTranslate(double x, double y, double z);
+	void PreRotate(double angle_radian, char axis);
+	void PreScale(double x, double y, double z);
+	void PreMultiply(const float m[4][4]);
+
+	// N = N * A
+	void PostTranslate(double x, double y, double z);
+	void PostRotate(double angle_radian, char axis);
+	void PostScale(double x, double y, double z);
+	void PostMultiply(const float m[4][4]);
+
+	const Affine& transform() const { return m_Transform; }
+	const Affine& inverse();
+
+private:
+	Affine m_Transform;
+	Affine m_Inverse;
+	bool   m_IsInverseValid;
+
+	void UpdateInverse();
+};
+
+void  AffineFromMatrix(const float m[4][4], Affine& a);
+void  AffineFromMatrix(const double m[4][4], Affine& a);
+void  AffineToMatrix(const Affine& a, float m[4][4]);
+void  AffineToMatrix(const Affine& a, double m[4][4]);
+void  AffineMultiply(const Affine& a, const Affine& b, Affine& result); // a * b
+
+template <typename T>
+inline void AffineTransformPoint(const Affine& a, const T in[3], T out[3])
+{
+	double x = in[0], y = in[1], z = in[2];
+	out[0] = static_cast<T>(a.Linear[0][0] * x + a.Linear[0][1] * y + a.Linear[0][2] * z + a.Translation[0]);
+	out[1] = static_cast<T>(a.Linear[1][0] * x + a.Linear[1][1] * y + a.Linear[1][2] * z + a.Translation[1]);
+	out[2] = static_cast<T>(a.Linear[2][0] * x + a.Linear[2][1] * y + a.Linear[2][2] * z + a.Translation[2]);
+}
+
+template <typename T>
+inline void AffineTransformVector(const Affine& a, const T in[3], T out[3])
+{
+	double x = in[0], y = in[1], z = in[2];
+	out[0] = static_cast<T>(a.Linear[0][0] * x + a.Linear[0][1] * y + a.Linear[0][2] * z);
+	out[1] = static_cast<T>(a.Linear[1][0] * x + a.Linear[1][1] * y + a.Linear[1][2] * z);
+	out[2] = static_cast<T>(a.Linear[2][0] * x + a.Linear[2][1] * y + a.Linear[2][2] * z);
+}
@@ -0,0 +1,177 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// transform.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "transform.h"
+#include "../thread/thread_pool.h"
+
+#include <algorithm>
+
+#if defined(__AVX__)
+#define USE_TRANSFORM_AVX
+#include <immintrin.h>
+#elif defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+#define USE_TRANSFORM_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// rows of the affine transform in single precision, w = translation
+	struct Rows
+	{
+		float M[3][4];
+
+		Rows(const Affine& a, bool isVector)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				M[i][0] = static_cast<float>(a.Linear[i][0]);
+				M[i][1] = static_cast<float>(a.Linear[i][1]);
+				M[i][2] = static_cast<float>(a.Linear[i][2]);
+				M[i][3] = isVector ? 0.0f : static_cast<float>(a.Translation[i]);
+			}
+		}
+	};
+
+	void TransformScalar(const Rows& r, const float *in, float *out, int begin, int end)
+	{
+		for (int n = begin; n < end; n++)
+		{
+			float x = in[n * 3 + 0];
+			float y = in[n * 3 + 1];
+			float z = in[n * 3 + 2];
+			out[n * 3 + 0] = r.M[0][0] * x + r.M[0][1] * y + r.M[0][2] * z + r.M[0][3];
+			out[n * 3 + 1] = r.M[1][0] * x + r.M[1][1] * y + r.M[1][2] * z + r.M[1][3];
+			out[n * 3 + 2] = r.M[2][0] * x + r.M[2][1] * y + r.M[2][2] * z + r.M[2][3];
+		}
+	}
+
+#if defined(USE_TRANSFORM_AVX)
+	const int TRANSFORM_SIMD_WIDTH = 8;
+	typedef __m256 VECTOR;
+	inline VECTOR Set1(float f) { return _mm256_set1_ps(f); }
+	inline VECTOR Add(VECTOR a, VECTOR b) { return _mm256_add_ps(a, b); }
+	inline VECTOR Mul(VECTOR a, VECTOR b) { return _mm256_mul_ps(a, b); }
+	#define SHUFFLE(a, b, imm) _mm256_shuffle_ps(a, b, imm)
+
+	// packed x0 y0 z0 x1 ... -> x, y, z (each 128-bit lane holds 4 points)
+	inline void Load(const float *p, VECTOR& m03, VECTOR& m14, VECTOR& m25)
+	{
+		m03 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p +  0)), _mm_loadu_ps(p + 12), 1);
+		m14 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p +  4)), _mm_loadu_ps(p + 16), 1);
+		m25 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p +  8)), _mm_loadu_ps(p + 20), 1);
+	}
+
+	inline void Store(float *p, VECTOR m03, VECTOR m14, VECTOR m25)
+	{
+		_mm_storeu_ps(p +  0, _mm256_castps256_ps128(m03));
+		_mm_storeu_ps(p +  4, _mm256_castps256_ps128(m14));
+		_mm_storeu_ps(p +  8, _mm256_castps256_ps128(m25));
+		_mm_storeu_ps(p + 12, _mm256_extractf128_ps(m03, 1));
+		_mm_storeu_ps(p + 16, _mm256_extractf128_ps(m14, 1));
+		_mm_storeu_ps(p + 20, _mm256_extractf128_ps(m25, 1));
+	}
+#elif defined(USE_TRANSFORM_SSE)
+	const int TRANSFORM_SIMD_WIDTH = 4;
+	typedef __m128 VECTOR;
+	inline VECTOR Set1(float f) { return _mm_set1_ps(f); }
+	inline VECTOR Add(VECTOR a, VECTOR b) { return _mm_add_ps(a, b); }
+	inline VECTOR Mul(VECTOR a, VECTOR b) { return _mm_mul_ps(a, b); }
+	#define SHUFFLE(a, b, imm) _mm_shuffle_ps(a, b, imm)
+
+	inline void Load(const float *p, VECTOR& m03, VECTOR& m14, VECTOR& m25)
+	{
+		m03 = _mm_loadu_ps(p + 0);
+		m14 = _mm_loadu_ps(p + 4);
+		m25 = _mm_loadu_ps(p + 8);
+	}
+
+	inline void Store(float *p, VECTOR m03, VECTOR m14, VECTOR m25)
+	{
+		_mm_storeu_ps(p + 0, m03);
+		_mm_storeu_ps(p + 4, m14);
+		_mm_storeu_ps(p + 8, m25);
+	}
+#endif
+
+#if defined(USE_TRANSFORM_AVX) || defined(USE_TRANSFORM_SSE)
+	void TransformRange(const Rows& r, const float *in, float *out, int begin, int end)
+	{
+		VECTOR m[3][4];
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				m[i][j] = Set1(r.M[i][j]);
+			}
+		}
+
+		int n = begin;
+		for (; n + TRANSFORM_SIMD_WIDTH <= end; n += TRANSFORM_SIMD_WIDTH)
+		{
+			// x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 -> SoA
+			VECTOR m03, m14, m25;
+			Load(&in[n * 3], m03, m14, m25);
+			VECTOR xy = SHUFFLE(m14, m25, _MM_SHUFFLE(2, 1, 3, 2)); // x2 y2 x3 y3
+			VECTOR yz = SHUFFLE(m03, m14, _MM_SHUFFLE(1, 0, 2, 1)); // y0 z0 y1 z1
+			VECTOR x  = SHUFFLE(m03, xy,  _MM_SHUFFLE(2, 0, 3, 0)); // x0 x1 x2 x3
+			VECTOR y  = SHUFFLE(yz,  xy,  _MM_SHUFFLE(3, 1, 2, 0)); // y0 y1 y2 y3
+			VECTOR z  = SHUFFLE(yz,  m25, _MM_SHUFFLE(3, 0, 3, 1)); // z0 z1 z2 z3
+
+			VECTOR ox = Add(Add(Mul(m[0][0], x), Mul(m[0][1], y)), Add(Mul(m[0][2], z), m[0][3]));
+			VECTOR oy = Add(Add(Mul(m[1][0], x), Mul(m[1][1], y)), Add(Mul(m[1][2], z), m[1][3]));
+			VECTOR oz = Add(Add(Mul(m[2][0], x), Mul(m[2][1], y)), Add(Mul(m[2][2], z), m[2][3]));
+
+			// SoA -> x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+			VECTOR rxy = SHUFFLE(ox, oy, _MM_SHUFFLE(2, 0, 2, 0)); // x0 x2 y0 y2
+			VECTOR ryz = SHUFFLE(oy, oz, _MM_SHUFFLE(3, 1, 3, 1)); // y1 y3 z1 z3
+			VECTOR rzx = SHUFFLE(oz, ox, _MM_SHUFFLE(3, 1, 2, 0)); // z0 z2 x1 x3
+			Store(&out[n * 3],
+				SHUFFLE(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0)),
+				SHUFFLE(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0)),
+				SHUFFLE(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+		TransformScalar(r, in, out, n, end);
+	}
+#else
+	void TransformRange(const Rows& r, const float *in, float *out, int begin, int end)
+	{
+		TransformScalar(r, in, out, begin, end);
+	}
+#endif
+
+	void TransformParallel(const Rows& r, const float *in, float *out, int count, int numThreads)
+	{
+		if ((numThreads <= 1) || (count < TRANSFORM_PARALLEL_THRESHOLD))
+		{
+			TransformRange(r, in, out, 0, count);
+			return;
+		}
+
+		numThreads = std::min(numThreads, count / (TRANSFORM_PARALLEL_THRESHOLD / 4));
+		// chunks of 16 points are 3 cache lines
+		int chunk = ((count + numThreads - 1) / numThreads + 15) & ~15;
+		ThreadPool::Instance().ParallelFor(0, count, chunk,
+			[&r, in, out](int begin, int end) { TransformRange(r, in, out, begin, end); }, numThreads);
+	}
+}
+
+void TransformPoints(const Affine& a, const float *in, float *out, int count, int numThreads)
+{
+	TransformParallel(Rows(a, false), in, out, count, numThreads);
+}
+
+void TransformVectors(const Affine& a, const float *in, float *out, int count, int numThreads)
+{
+	TransformParallel(Rows(a, true), in, out, count, numThreads);
+}
@@ -0,0 +1,24 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// transform.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "navigation.h"
+
+// Batch transforms of count packed (x, y, z) points or vectors in single
+// precision; in and out may be the same array.
+// numThreads > 1 splits batches larger than TRANSFORM_PARALLEL_THRESHOLD.
+const int TRANSFORM_PARALLEL_THRESHOLD = 65536;
+
+void TransformPoints(const Affine& a, const float *in, float *out, int count, int numThreads = 1);
+void TransformVectors(const Affine& a, const float *in, float *out, int count, int numThreads = 1);
@@ -0,0 +1,476 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// arena.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "arena.h"
+
+#include <new>
+#include <thread>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+	const unsigned int ARENA_MAGIC = 0x434c4341; // "CLCA"
+	const unsigned char SPAN_FREE  = 0xff;
+	const unsigned char SPAN_LARGE = 0xfe;
+
+	// block sizes in units of ARENA_ALIGNMENT (at most 25 % wasted)
+	const unsigned int CLASS_UNITS[ARENA_NUM_SIZE_CLASSES] = {
+		1, 2, 3, 4, 5, 6, 8, 10, 12, 16, 20, 24, 32, 40, 48, 64, 80, 96, 128, 160, 192, 256, 320, 384, 512 };
+
+	const size_t MAX_SMALL_UNITS = ARENA_MAX_SMALL_SIZE / ARENA_ALIGNMENT;
+
+	struct ClassTable
+	{
+		unsigned char Class[MAX_SMALL_UNITS + 1];
+
+		ClassTable()
+		{
+			int sizeClass = 0;
+			for (size_t units = 0; units <= MAX_SMALL_UNITS; units++)
+			{
+				while (CLASS_UNITS[sizeClass] < units)
+				{
+					sizeClass++;
+				}
+				Class[units] = static_cast<unsigned char>(sizeClass);
+			}
+		}
+	};
+
+	const ClassTable CLASS_TABLE;
+
+	size_t ClassSize(int sizeClass)
+	{
+		return CLASS_UNITS[sizeClass] * ARENA_ALIGNMENT;
+	}
+
+	unsigned int ClassBlocks(int sizeClass)
+	{
+		return static_cast<unsigned int>(ARENA_SPAN_SIZE / ClassSize(sizeClass));
+	}
+
+	size_t RoundUp(size_t size, size_t alignment)
+	{
+		return (size + alignment - 1) / alignment * alignment;
+	}
+
+	int LowestBit(unsigned long long bits) // bits != 0
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return static_cast<int>(index);
+#else
+		return __builtin_ctzll(bits);
+#endif
+	}
+
+	// list of the free runs of count spans: one per length up to
+	// ARENA_MAX_SPAN_LIST, then one per power of two
+	int RunList(size_t count)
+	{
+		if (count <= static_cast<size_t>(ARENA_MAX_SPAN_LIST))
+		{
+			return static_cast<int>(count) - 1;
+		}
+		int log2 = 0;
+		while ((count >> (log2 + 1)) != 0)
+		{
+			log2++;
+		}
+		return ARENA_MAX_SPAN_LIST + log2 - 6; // 2^6 = ARENA_MAX_SPAN_LIST
+	}
+}
+
+Arena::Arena(size_t size, bool isLockedByCaller)
+{
+	m_Magic = 0;
+	m_Lock.store(0);
+	m_IsLockedByCaller = isLockedByCaller;
+	m_IsAbandoned = false;
+	m_Size = size;
+	m_Address = reinterpret_cast<size_t>(this);
+	m_Root = 0;
+	m_NumSpans = size / ARENA_SPAN_SIZE;
+	for (int i = 0; i < ARENA_NUM_SIZE_CLASSES; i++)
+	{
+		m_ClassSpan[i] = 0;
+	}
+	for (int i = 0; i < ARENA_NUM_RUN_LISTS; i++)
+	{
+		m_FreeRun[i] = 0;
+	}
+	for (int i = 0; i < ARENA_NUM_RUN_LISTS / 64; i++)
+	{
+		m_FreeRunMask[i] = 0;
+	}
+	m_LiveBytes = 0;
+	m_PeakBytes = 0;
+
+	// the header and the span table occupy the first spans
+	size_t headerSize = sizeof(Arena) + m_NumSpans * sizeof(Span);
+	m_TopSpan = RoundUp(headerSize, ARENA_SPAN_SIZE) / ARENA_SPAN_SIZE;
+	for (size_t i = 0; i < m_NumSpans; i++)
+	{
+		Span& span = spans()[i];
+		span.FreeBlock = 0;
+		span.Next = 0;
+		span.Previous = 0;
+		span.Count = 0;
+		span.Carved = 0;
+		span.Class = (i < m_TopSpan) ? SPAN_LARGE : SPAN_FREE;
+	}
+	m_Magic = ARENA_MAGIC; // last, so that Attach() finds only complete arenas
+}
+
+Arena* Arena::Create(void *base, size_t size, bool isLockedByCaller)
+{
+	size = size / ARENA_SPAN_SIZE * ARENA_SPAN_SIZE;
+	if ((base == nullptr) || (reinterpret_cast<size_t>(base) % ARENA_ALIGNMENT != 0) || (size < 4 * ARENA_SPAN_SIZE))
+	{
+		return nullptr;
+	}
+	if (RoundUp(sizeof(Arena) + size / ARENA_SPAN_SIZE * sizeof(Span), ARENA_SPAN_SIZE) >= size)
+	{
+		return nullptr; // no span left after the span table
+	}
+	return new (base) Arena(size, isLockedByCaller);
+}
+
+Arena* Arena::Attach(void *base)
+{
+	Arena *arena = reinterpret_cast<Arena*>(base);
+	return ((arena != nullptr) && (arena->m_Magic == ARENA_MAGIC)) ? arena : nullptr;
+}
+
+void Arena::Lock()
+{
+	if (m_IsLockedByCaller)
+	{
+		return;
+	}
+	int expected = 0;
+	for (int spin = 0; !m_Lock.compare_exchange_weak(expected, 1, std::memory_order_acquire); spin++)
+	{
+		expected = 0;
+		if (spin >= 64)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void Arena::Unlock()
+{
+	if (!m_IsLockedByCaller)
+	{
+		m_Lock.store(0, std::memory_order_release);
+	}
+}
+
+void* Arena::Allocate(size_t size)
+{
+	if (m_IsAbandoned)
+	{
+		return nullptr;
+	}
+	size_t units = (size > 0) ? (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT : 1;
+	Lock();
+	size_t offset = 0;
+	size_t allocated = 0;
+	if (units <= MAX_SMALL_UNITS)
+	{
+		int sizeClass = CLASS_TABLE.Class[units];
+		offset = AllocateBlock(sizeClass);
+		allocated = ClassSize(sizeClass);
+	}
+	else
+	{
+		size_t count = RoundUp(units * ARENA_ALIGNMENT, ARENA_SPAN_SIZE) / ARENA_SPAN_SIZE;
+		size_t span = AllocateSpans(count);
+		if (span != 0)
+		{
+			TagRun(span, count, SPAN_LARGE);
+			offset = span * ARENA_SPAN_SIZE;
+			allocated = count * ARENA_SPAN_SIZE;
+		}
+	}
+
+	if (offset != 0)
+	{
+		m_LiveBytes += allocated;
+		if (m_LiveBytes > m_PeakBytes)
+		{
+			m_PeakBytes = m_LiveBytes;
+		}
+	}
+	Unlock();
+	return (offset != 0) ? at(offset) : nullptr;
+}
+
+void Arena::Free(void *ptr)
+{
+	if ((ptr == nullptr) || !Contains(ptr) || m_IsAbandoned)
+	{
+		return;
+	}
+	size_t offset = offsetOf(ptr);
+	size_t span = offset / ARENA_SPAN_SIZE;
+	Lock();
+	unsigned char sizeClass = spans()[span].Class;
+	if (sizeClass < ARENA_NUM_SIZE_CLASSES)
+	{
+		m_LiveBytes -= ClassSize(sizeClass);
+		FreeBlock(offset, span);
+	}
+	else if ((sizeClass == SPAN_LARGE) && (span >= 1) && (offset % ARENA_SPAN_SIZE == 0))
+	{
+		size_t count = spans()[span].Count;
+		m_LiveBytes -= count * ARENA_SPAN_SIZE;
+		FreeSpans(span, count);
+	}
+	Unlock();
+}
+
+size_t Arena::AllocatedSize(const void *ptr) const
+{
+	if ((ptr == nullptr) || !Contains(ptr))
+	{
+		return 0;
+	}
+	const Span& span = spans()[offsetOf(ptr) / ARENA_SPAN_SIZE];
+	if (span.Class < ARENA_NUM_SIZE_CLASSES)
+	{
+		return ClassSize(span.Class);
+	}
+	return (span.Class == SPAN_LARGE) ? span.Count * ARENA_SPAN_SIZE : 0;
+}
+
+size_t Arena::AllocateBlock(int sizeClass)
+{
+	size_t index = m_ClassSpan[sizeClass];
+	if (index == 0)
+	{
+		index = AllocateSpans(1);
+		if (index == 0)
+		{
+			return 0;
+		}
+		Span& span = spans()[index];
+		span.Class = static_cast<unsigned char>(sizeClass);
+		span.FreeBlock = 0;
+		span.Count = 0;
+		span.Carved = 0;
+		span.Next = 0;
+		span.Previous = 0;
+		m_ClassSpan[sizeClass] = index;
+	}
+
+	Span& span = spans()[index];
+	size_t offset;
+	if (span.FreeBlock != 0)
+	{
+		offset = span.FreeBlock;
+		span.FreeBlock = *reinterpret_cast<size_t*>(at(offset));
+	}
+	else
+	{
+		offset = index * ARENA_SPAN_SIZE + span.Carved * ClassSize(sizeClass);
+		span.Carved++;
+	}
+	span.Count++;
+
+	if ((span.FreeBlock == 0) && (span.Carved == ClassBlocks(sizeClass)))
+	{
+		// full: off the list of the class until a block is freed
+		m_ClassSpan[sizeClass] = span.Next;
+		if (span.Next != 0)
+		{
+			spans()[span.Next].Previous = 0;
+		}
+		span.Next = 0;
+	}
+	return offset;
+}
+
+void Arena::FreeBlock(size_t offset, size_t index)
+{
+	Span& span = spans()[index];
+	int sizeClass = span.Class;
+	bool isFull = (span.FreeBlock == 0) && (span.Carved == ClassBlocks(sizeClass));
+	*reinterpret_cast<size_t*>(at(offset)) = span.FreeBlock;
+	span.FreeBlock = offset;
+	span.Count--;
+
+	if (isFull)
+	{
+		span.Previous = 0;
+		span.Next = m_ClassSpan[sizeClass];
+		if (span.Next != 0)
+		{
+			spans()[span.Next].Previous = index;
+		}
+		m_ClassSpan[sizeClass] = index;
+	}
+	if (span.Count == 0)
+	{
+		// empty: back to the free runs, where it can merge with its neighbours
+		if (span.Previous != 0)
+		{
+			spans()[span.Previous].Next = span.Next;
+		}
+		else
+		{
+			m_ClassSpan[sizeClass] = span.Next;
+		}
+		if (span.Next != 0)
+		{
+			spans()[span.Next].Previous = span.Previous;
+		}
+		FreeSpans(index, 1);
+	}
+}
+
+size_t Arena::AllocateSpans(size_t count)
+{
+	// the first non-empty list from the one of count on; a list per power of
+	// two may hold shorter runs, so a long run looks from the next list on
+	int first = RunList(count);
+	if (count > static_cast<size_t>(ARENA_MAX_SPAN_LIST))
+	{
+		first++;
+	}
+	size_t span = 0;
+	for (int word = first / 64; (word < ARENA_NUM_RUN_LISTS / 64) && (span == 0); word++)
+	{
+		unsigned long long mask = m_FreeRunMask[word];
+		if (word == first / 64)
+		{
+			mask &= ~0ULL << (first % 64);
+		}
+		if (mask != 0)
+		{
+			span = m_FreeRun[word * 64 + LowestBit(mask)];
+		}
+	}
+
+	if ((span == 0) && (m_TopSpan + count <= m_NumSpans))
+	{
+		span = m_TopSpan;
+		m_TopSpan += count;
+		return span;
+	}
+	if ((span == 0) && (count > static_cast<size_t>(ARENA_MAX_SPAN_LIST)))
+	{
+		// nearly exhausted: a run of the list of count may still be long enough
+		for (size_t run = m_FreeRun[RunList(count)]; run != 0; run = spans()[run].Next)
+		{
+			if (spans()[run].Count >= count)
+			{
+				span = run;
+				break;
+			}
+		}
+	}
+	if (span == 0)
+	{
+		return 0;
+	}
+
+	// split off the rest; its neighbours are in use, so it is not merged
+	size_t runCount = spans()[span].Count;
+	RemoveRun(span);
+	if (runCount > count)
+	{
+		InsertRun(span + count, runCount - count);
+	}
+	return span;
+}
+
+void Arena::FreeSpans(size_t span, size_t count)
+{
+	// merge with the free runs before and after, found by their boundary tags
+	const Span& before = spans()[span - 1];
+	if (before.Class == SPAN_FREE)
+	{
+		size_t beforeCount = before.Count;
+		RemoveRun(span - beforeCount);
+		span -= beforeCount;
+		count += beforeCount;
+	}
+	if ((span + count < m_TopSpan) && (spans()[span + count].Class == SPAN_FREE))
+	{
+		size_t afterCount = spans()[span + count].Count;
+		RemoveRun(span + count);
+		count += afterCount;
+	}
+
+	if (span + count == m_TopSpan)
+	{
+		m_TopSpan = span; // back to the never used spans
+		return;
+	}
+	InsertRun(span, count);
+}
+
+void Arena::InsertRun(size_t span, size_t count)
+{
+	TagRun(span, count, SPAN_FREE);
+	int list = RunList(count);
+	Span& run = spans()[span];
+	run.Previous = 0;
+	run.Next = m_FreeRun[list];
+	if (run.Next != 0)
+	{
+		spans()[run.Next].Previous = span;
+	}
+	m_FreeRun[list] = span;
+	m_FreeRunMask[list / 64] |= 1ULL << (list % 64);
+}
+
+void Arena::RemoveRun(size_t span)
+{
+	Span& run = spans()[span];
+	int list = RunList(run.Count);
+	if (run.Previous != 0)
+	{
+		spans()[run.Previous].Next = run.Next;
+	}
+	else
+	{
+		m_FreeRun[list] = run.Next;
+		if (run.Next == 0)
+		{
+			m_FreeRunMask[list / 64] &= ~(1ULL << (list % 64));
+		}
+	}
+	if (run.Next != 0)
+	{
+		spans()[run.Next].Previous = run.Previous;
+	}
+	run.Next = 0;
+	run.Previous = 0;
+}
+
+void Arena::TagRun(size_t span, size_t count, unsigned char spanClass)
+{
+	Span& first = spans()[span];
+	Span& last = spans()[span + count - 1];
+	first.Class = spanClass;
+	first.Count = static_cast<unsigned int>(count);
+	last.Class = spanClass;
+	last.Count = static_cast<unsigned int>(count);
+}
@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// arena.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+const size_t ARENA_ALIGNMENT = 64;
+const size_t ARENA_SPAN_SIZE = 65536;
+const size_t ARENA_MAX_SMALL_SIZE = 32768;
+const int    ARENA_NUM_SIZE_CLASSES = 25;
+const int    ARENA_MAX_SPAN_LIST = 64;  // runs of up to this many spans have a list per length
+const int    ARENA_NUM_RUN_LISTS = 128; // and longer runs a list per power of two
+
+// Allocator over one contiguous region for CAVEMalloc().
+//
+// The region is divided into 64 KB spans. A span is either carved into blocks
+// of one size class (multiples of 64 bytes up to 32 KB) or is part of a run of
+// spans for a larger allocation. The size class of a pointer is found in the
+// span table, so blocks have no headers and stay 64-byte aligned.
+//
+// Each span keeps its own free blocks, and the spans of a class with free
+// blocks are linked, so that a span whose blocks are all freed goes back to
+// the free runs. Free runs are kept in a list per length (per power of two
+// for runs longer than 64 spans) with a bitmap of the non-empty lists, so
+// that the smallest list that fits is found in constant time and the rest of
+// a longer run is split off. The first and the last span of every run carry
+// its length (boundary tags), so that a freed run is merged with free
+// neighbours in constant time.
+//
+// The Arena object is the header at the start of the region and all its state
+// is stored as offsets in the region, so that processes mapping the region at
+// other addresses can share it.
+class Arena
+{
+public:
+	// isLockedByCaller: the callers serialize Allocate() and Free() (a shared
+	// arena with a named mutex), otherwise a spin lock in the arena is used
+	static Arena* Create(void *base, size_t size, bool isLockedByCaller = false); // nullptr if too small
+	static Arena* Attach(void *base); // nullptr if not an arena
+
+	void* Allocate(size_t size); // nullptr when exhausted
+	void  Free(void *ptr);
+	bool  Contains(const void *ptr) const
+	{
+		return (ptr >= reinterpret_cast<const char*>(this)) && (ptr < reinterpret_cast<const char*>(this) + m_Size);
+	}
+	size_t AllocatedSize(const void *ptr) const; // rounded up to the size class
+
+	// after a process died inside Allocate() or Free(), the arena may be
+	// inconsistent: Allocate() fails and Free() does nothing from then on
+	void MarkAbandoned() { m_IsAbandoned = true; }
+	bool isAbandoned() const { return m_IsAbandoned; }
+
+	// application data that other processes can find after Attach()
+	void  SetRoot(void *ptr) { m_Root = (ptr != nullptr) ? offsetOf(ptr) : 0; }
+	void* root() { return (m_Root != 0) ? at(m_Root) : nullptr; }
+
+	// address the creator placed the region at; pointers into the region are
+	// only valid in processes that map it at the same address
+	void* address() const { return reinterpret_cast<void*>(m_Address); }
+
+	size_t size() const { return m_Size; }
+	size_t liveBytes() const { return m_LiveBytes; }
+	size_t peakBytes() const { return m_PeakBytes; }
+
+private:
+	Arena(size_t size, bool isLockedByCaller);
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	// span table entry; links are span indices, 0: none (span 0 holds the header)
+	struct Span
+	{
+		size_t        FreeBlock; // class spans: offset of the first free block, 0: none
+		size_t        Next;      // in the list of the class or of the free run length
+		size_t        Previous;
+		unsigned int  Count;     // runs: spans (first and last span), class spans: live blocks
+		unsigned int  Carved;    // class spans: blocks carved so far
+		unsigned char Class;     // size class, SPAN_LARGE or SPAN_FREE
+	};
+
+	unsigned int       m_Magic;
+	std::atomic<int>   m_Lock;      // spin lock, unless m_IsLockedByCaller
+	bool               m_IsLockedByCaller;
+	bool               m_IsAbandoned;
+	size_t             m_Size;
+	size_t             m_Address;
+	size_t             m_Root;
+	size_t             m_NumSpans;
+	size_t             m_TopSpan;   // spans from here have never been used or were merged back
+	size_t             m_ClassSpan[ARENA_NUM_SIZE_CLASSES]; // spans with free blocks
+	size_t             m_FreeRun[ARENA_NUM_RUN_LISTS];
+	unsigned long long m_FreeRunMask[ARENA_NUM_RUN_LISTS / 64]; // non-empty lists
+	size_t             m_LiveBytes;
+	size_t             m_PeakBytes;
+
+	// followed by the span table
+	Span* spans() { return reinterpret_cast<Span*>(this + 1); }
+	const Span* spans() const { return reinterpret_cast<const Span*>(this + 1); }
+
+	char*  at(size_t offset) { return reinterpret_cast<char*>(this) + offset; }
+	size_t offsetOf(const void *ptr) const { return reinterpret_cast<const char*>(ptr) - reinterpret_cast<const char*>(this); }
+
+	void   Lock();
+	void   Unlock();
+	size_t AllocateBlock(int sizeClass); // offset, 0 when exhausted
+	void   FreeBlock(size_t offset, size_t span);
+	size_t AllocateSpans(size_t count);  // first span, 0 when exhausted
+	void   FreeSpans(size_t span, size_t count);
+	void   InsertRun(size_t span, size_t count);
+	void   RemoveRun(size_t span);
+	void   TagRun(size_t span, size_t count, unsigned char spanClass);
+};
@@ -0,0 +1,204 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// frame_allocator.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "frame_allocator.h"
+#include "memory_stats.h"
+
+#include <atomic>
+#include <cstdlib>
+
+namespace
+{
+	std::atomic<long long> s_Frame(0);
+	std::atomic<size_t> s_BlockSize(FRAME_ALLOC_BLOCK_SIZE);
+	std::atomic<size_t> s_HighWater(0);
+
+	struct Block
+	{
+		Block *p_Next;
+		size_t m_Size; // bytes after the header
+	};
+
+	const size_t BLOCK_HEADER = (sizeof(Block) + FRAME_ALLOC_ALIGNMENT - 1) / FRAME_ALLOC_ALIGNMENT * FRAME_ALLOC_ALIGNMENT;
+
+	char* BlockData(Block *block)
+	{
+		return reinterpret_cast<char*>(block) + BLOCK_HEADER;
+	}
+
+	Block* NewBlock(size_t size)
+	{
+		Block *block = static_cast<Block*>(malloc(BLOCK_HEADER + size));
+		if (block != nullptr)
+		{
+			block->p_Next = nullptr;
+			block->m_Size = size;
+			MemoryStats::Allocate(MEMORY_FRAME_ALLOC, BLOCK_HEADER + size);
+		}
+		return block;
+	}
+
+	void FreeBlocks(Block *block)
+	{
+		while (block != nullptr)
+		{
+			Block *next = block->p_Next;
+			MemoryStats::Free(MEMORY_FRAME_ALLOC, BLOCK_HEADER + block->m_Size);
+			free(block);
+			block = next;
+		}
+	}
+
+	struct Buffer
+	{
+		Block *p_First;
+		Block *p_Last;
+		char  *p_Cursor;
+		char  *p_End;
+		size_t m_Used;     // including alignment padding
+		size_t m_Capacity;
+
+		Buffer() : p_First(nullptr), p_Last(nullptr), p_Cursor(nullptr), p_End(nullptr), m_Used(0), m_Capacity(0) {}
+		~Buffer() { FreeBlocks(p_First); }
+
+		void Rewind()
+		{
+			if ((p_First != nullptr) && (p_First->p_Next != nullptr))
+			{
+				// merge the blocks of the last overflow
+				size_t size = m_Capacity;
+				FreeBlocks(p_First);
+				p_First = NewBlock(size);
+				m_Capacity = (p_First != nullptr) ? size : 0;
+			}
+			p_Last = p_First;
+			p_Cursor = (p_First != nullptr) ? BlockData(p_First) : nullptr;
+			p_End = (p_First != nullptr) ? p_Cursor + p_First->m_Size : nullptr;
+			m_Used = 0;
+		}
+
+		void* Allocate(size_t size, size_t alignment)
+		{
+			size_t address = reinterpret_cast<size_t>(p_Cursor);
+			size_t padding = (alignment - address % alignment) % alignment;
+			if ((p_Cursor == nullptr) || (padding + size > static_cast<size_t>(p_End - p_Cursor)))
+			{
+				size_t blockSize = s_BlockSize.load();
+				if (blockSize < size + alignment)
+				{
+					blockSize = size + alignment;
+				}
+				Block *block = NewBlock(blockSize);
+				if (block == nullptr)
+				{
+					return nullptr;
+				}
+				if (p_Last != nullptr)
+				{
+					p_Last->p_Next = block;
+				}
+				else
+				{
+					p_First = block;
+				}
+				p_Last = block;
+				m_Used += p_End - p_Cursor; // the rest of the previous block is lost for this frame
+				m_Capacity += blockSize;
+				p_Cursor = BlockData(block);
+				p_End = p_Cursor + blockSize;
+				address = reinterpret_cast<size_t>(p_Cursor);
+				padding = (alignment - address % alignment) % alignment;
+			}
+			char *ptr = p_Cursor + padding;
+			p_Cursor = ptr + size;
+			m_Used += padding + size;
+			return ptr;
+		}
+	};
+
+	struct ThreadArena
+	{
+		Buffer    m_Buffer[2];
+		int       m_Current;
+		long long m_Frame;
+
+		ThreadArena() : m_Current(0), m_Frame(-1) {}
+
+		Buffer& current()
+		{
+			long long frame = s_Frame.load(std::memory_order_acquire);
+			if (frame != m_Frame)
+			{
+				// the older buffer is reused; both are if this thread skipped a frame
+				if (frame != m_Frame + 1)
+				{
+					m_Buffer[m_Current].Rewind();
+				}
+				m_Current = 1 - m_Current;
+				m_Buffer[m_Current].Rewind();
+				m_Frame = frame;
+			}
+			return m_Buffer[m_Current];
+		}
+	};
+
+	thread_local ThreadArena t_Arena;
+
+	void UpdateHighWater(size_t used)
+	{
+		size_t highWater = s_HighWater.load(std::memory_order_relaxed);
+		while ((used > highWater) && !s_HighWater.compare_exchange_weak(highWater, used, std::memory_order_relaxed))
+		{
+		}
+	}
+}
+
+void FrameAllocator::BeginFrame()
+{
+	s_Frame.fetch_add(1, std::memory_order_release);
+}
+
+void* FrameAllocator::Allocate(size_t size, size_t alignment)
+{
+	if ((alignment == 0) || ((alignment & (alignment - 1)) != 0))
+	{
+		alignment = FRAME_ALLOC_ALIGNMENT;
+	}
+	Buffer& buffer = t_Arena.current();
+	void *ptr = buffer.Allocate((size > 0) ? size : 1, alignment);
+	UpdateHighWater(buffer.m_Used);
+	return ptr;
+}
+
+void FrameAllocator::SetBlockSize(size_t size)
+{
+	if (size > 0)
+	{
+		s_BlockSize.store(size);
+	}
+}
+
+long long FrameAllocator::frame()
+{
+	return s_Frame.load();
+}
+
+size_t FrameAllocator::usedBytes()
+{
+	return t_Arena.current().m_Used;
+}
+
+size_t FrameAllocator::highWater()
+{
+	return s_HighWater.load();
+}
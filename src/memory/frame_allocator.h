@@ -0,0 +1,38 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// frame_allocator.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+const size_t FRAME_ALLOC_BLOCK_SIZE = 1024 * 1024; // default of the first block per buffer
+const size_t FRAME_ALLOC_ALIGNMENT  = 16;          // alignment = 0: default
+
+// Per-thread linear allocator for data that lives for one or two frames.
+//
+// Every thread has two buffers. At the first Allocate() of a new frame the
+// older buffer is rewound and becomes current, so memory allocated in frame
+// N stays valid until the end of frame N + 1. A buffer that overflowed grows
+// by extra blocks during the frame and is merged into one block when it is
+// rewound, so the steady state does not allocate from the heap.
+class FrameAllocator
+{
+public:
+	static void   BeginFrame(); // called by the display thread at frame boundaries
+	static void*  Allocate(size_t size, size_t alignment);
+	static void   SetBlockSize(size_t size); // for buffers created afterwards
+
+	static long long frame();
+	static size_t usedBytes(); // the calling thread in the current frame
+	static size_t highWater(); // the largest frame of any thread
+};
@@ -0,0 +1,175 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// memory_stats.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "memory_stats.h"
+
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+
+namespace
+{
+	const char* CATEGORY_NAMES[MEMORY_CATEGORY_COUNT] = {
+		"CAVEMalloc", "frame alloc", "host buffers", "GPU render targets", "GPU quad layers", "GPU camera" };
+
+	const double RATE_WINDOW = 1.0; // seconds
+
+	struct Category
+	{
+		std::atomic<long long> LiveBytes;
+		std::atomic<long long> PeakBytes;
+		std::atomic<long long> Allocations;
+		std::atomic<long long> Frees;
+		std::atomic<long long> AllocatedBytes; // total, for the rates
+	};
+
+	Category s_Category[MEMORY_CATEGORY_COUNT];
+
+	// rates, updated by the display thread
+	std::mutex s_RateMutex;
+	float     s_AllocationsPerFrame[MEMORY_CATEGORY_COUNT];
+	float     s_BytesPerFrame[MEMORY_CATEGORY_COUNT];
+	long long s_WindowAllocations[MEMORY_CATEGORY_COUNT];
+	long long s_WindowBytes[MEMORY_CATEGORY_COUNT];
+	double    s_WindowStart = -1.0;
+	int       s_WindowFrames = 0;
+	double    s_LogInterval = 0.0;
+	double    s_LastLog = 0.0;
+
+	bool IsValid(int category)
+	{
+		return (category >= 0) && (category < MEMORY_CATEGORY_COUNT);
+	}
+
+	double Megabytes(long long bytes)
+	{
+		return static_cast<double>(bytes) / (1024.0 * 1024.0);
+	}
+}
+
+void MemoryStats::Allocate(int category, long long bytes)
+{
+	if (!IsValid(category) || (bytes <= 0))
+	{
+		return;
+	}
+	Category& counter = s_Category[category];
+	long long live = counter.LiveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	long long peak = counter.PeakBytes.load(std::memory_order_relaxed);
+	while ((live > peak) && !counter.PeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+	{
+	}
+	counter.Allocations.fetch_add(1, std::memory_order_relaxed);
+	counter.AllocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void MemoryStats::Free(int category, long long bytes)
+{
+	if (!IsValid(category) || (bytes <= 0))
+	{
+		return;
+	}
+	s_Category[category].LiveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+	s_Category[category].Frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MemoryStats::Get(int category, MemoryCounters& counters)
+{
+	if (!IsValid(category))
+	{
+		counters = MemoryCounters();
+		return;
+	}
+	const Category& counter = s_Category[category];
+	counters.LiveBytes   = counter.LiveBytes.load();
+	counters.PeakBytes   = counter.PeakBytes.load();
+	counters.Allocations = counter.Allocations.load();
+	counters.Frees       = counter.Frees.load();
+	std::lock_guard<std::mutex> lock(s_RateMutex);
+	counters.AllocationsPerFrame = s_AllocationsPerFrame[category];
+	counters.BytesPerFrame       = s_BytesPerFrame[category];
+}
+
+const char* MemoryStats::name(int category)
+{
+	return IsValid(category) ? CATEGORY_NAMES[category] : "";
+}
+
+void MemoryStats::EndFrame(double time)
+{
+	bool isLogTime = false;
+	{
+		std::lock_guard<std::mutex> lock(s_RateMutex);
+		if (s_WindowStart < 0.0)
+		{
+			s_WindowStart = time;
+			s_LastLog = time;
+			for (int i = 0; i < MEMORY_CATEGORY_COUNT; i++)
+			{
+				s_WindowAllocations[i] = s_Category[i].Allocations.load();
+				s_WindowBytes[i] = s_Category[i].AllocatedBytes.load();
+			}
+		}
+		s_WindowFrames++;
+
+		if (time - s_WindowStart >= RATE_WINDOW)
+		{
+			for (int i = 0; i < MEMORY_CATEGORY_COUNT; i++)
+			{
+				long long allocations = s_Category[i].Allocations.load();
+				long long bytes = s_Category[i].AllocatedBytes.load();
+				s_AllocationsPerFrame[i] = static_cast<float>(allocations - s_WindowAllocations[i]) / s_WindowFrames;
+				s_BytesPerFrame[i] = static_cast<float>(bytes - s_WindowBytes[i]) / s_WindowFrames;
+				s_WindowAllocations[i] = allocations;
+				s_WindowBytes[i] = bytes;
+			}
+			s_WindowStart = time;
+			s_WindowFrames = 0;
+		}
+
+		if ((s_LogInterval > 0.0) && (time - s_LastLog >= s_LogInterval))
+		{
+			s_LastLog = time;
+			isLogTime = true;
+		}
+	}
+
+	if (isLogTime)
+	{
+		Log();
+	}
+}
+
+void MemoryStats::SetLogInterval(double seconds)
+{
+	std::lock_guard<std::mutex> lock(s_RateMutex);
+	s_LogInterval = (seconds > 0.0) ? seconds : 0.0;
+}
+
+void MemoryStats::Log()
+{
+	std::cout << "CLCL: memory (live / peak MB, allocations / frame, KB / frame)" << std::endl;
+	for (int i = 0; i < MEMORY_CATEGORY_COUNT; i++)
+	{
+		MemoryCounters counters;
+		Get(i, counters);
+		std::cout << "  " << std::left << std::setw(20) << CATEGORY_NAMES[i] << std::right << std::fixed
+			<< std::setprecision(1) << std::setw(9) << Megabytes(counters.LiveBytes)
+			<< " / " << std::setw(9) << Megabytes(counters.PeakBytes)
+			<< std::setprecision(2) << std::setw(10) << counters.AllocationsPerFrame
+			<< std::setw(10) << counters.BytesPerFrame / 1024.0f << std::endl;
+	}
+	std::cout.unsetf(std::ios::floatfield);
+	std::cout << std::setprecision(6);
+}
@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// memory_stats.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+typedef enum {
+	MEMORY_CAVEMALLOC = 0,    // CAVEMalloc()
+	MEMORY_FRAME_ALLOC,       // CAVEFrameAlloc() buffers of all threads
+	MEMORY_HOST_BUFFER,       // CLCL image buffers (mirror, left eye)
+	MEMORY_GPU_RENDER_TARGET, // eye swap chain, depth buffer, mirror texture
+	MEMORY_GPU_QUAD_LAYER,    // quad layer swap chains
+	MEMORY_GPU_CAMERA,        // camera textures
+	MEMORY_CATEGORY_COUNT
+} MEMORY_CATEGORY;
+
+struct MemoryCounters
+{
+	long long LiveBytes;
+	long long PeakBytes;
+	long long Allocations;
+	long long Frees;
+	float     AllocationsPerFrame; // averaged over about one second
+	float     BytesPerFrame;
+};
+
+// Process-wide memory counters per category. GPU categories are estimates
+// from the sizes and formats of the objects CLCL creates; memory allocated by
+// the runtime or the camera SDKs is not included.
+class MemoryStats
+{
+public:
+	static void Allocate(int category, long long bytes);
+	static void Free(int category, long long bytes);
+	static void Get(int category, MemoryCounters& counters);
+	static const char* name(int category);
+
+	// called by the display thread once per frame
+	static void EndFrame(double time);
+	static void SetLogInterval(double seconds); // 0: no log
+	static void Log();
+
+	// estimated size of a GL image with "count" buffers (e.g. swap chain length)
+	static long long ImageBytes(int width, int height, int bytesPerPixel, int count = 1)
+	{
+		return static_cast<long long>(width) * height * bytesPerPixel * count;
+	}
+};
@@ -0,0 +1,172 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// simulation.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "simulation.h"
+#include "../thread/scheduling.h"
+#include "../thread/wait_timer.h"
+
+#include <algorithm>
+#include <cstring>
+
+FixedStepSimulation::FixedStepSimulation()
+{
+	m_IsRunning.store(false);
+	m_Interval = 0.0;
+	m_Lead.store(0.0);
+	m_StepTime.store(0.0);
+	m_Time[0] = 0.0;
+	m_Time[1] = 0.0;
+	m_Alpha = 1.0f;
+}
+
+FixedStepSimulation::~FixedStepSimulation()
+{
+	Stop();
+}
+
+void FixedStepSimulation::Start(double rate, std::function<void()> step, std::function<double()> clock)
+{
+	Stop();
+	if ((rate <= 0.0) || !step || !clock)
+	{
+		return;
+	}
+	m_Step = step;
+	m_Clock = clock;
+	m_Interval = 1.0 / rate;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Time[0] = m_Time[1] = m_Clock();
+	}
+	m_StepTime.store(m_Time[1]);
+	m_IsRunning.store(true);
+	m_Thread = std::thread(&FixedStepSimulation::Run, this);
+}
+
+void FixedStepSimulation::Stop()
+{
+	m_IsRunning.store(false);
+	if (m_Thread.joinable())
+	{
+		m_Thread.join();
+	}
+}
+
+int FixedStepSimulation::RegisterArray(float *source, float *display, int count)
+{
+	if ((source == nullptr) || (display == nullptr) || (count <= 0))
+	{
+		return -1;
+	}
+	Array array;
+	array.p_Source = source;
+	array.p_Display = display;
+	array.Count = count;
+	array.State[0].assign(source, source + count);
+	array.State[1] = array.State[0];
+	memcpy(display, source, sizeof(float) * count);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (size_t i = 0; i < m_Array.size(); i++)
+	{
+		if (m_Array[i].Count == 0)
+		{
+			m_Array[i] = std::move(array);
+			return static_cast<int>(i);
+		}
+	}
+	m_Array.push_back(std::move(array));
+	return static_cast<int>(m_Array.size()) - 1;
+}
+
+void FixedStepSimulation::UnregisterArray(int arrayID)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if ((arrayID < 0) || (arrayID >= static_cast<int>(m_Array.size())))
+	{
+		return;
+	}
+	Array& array = m_Array[arrayID];
+	array.Count = 0;
+	array.State[0].clear();
+	array.State[1].clear();
+}
+
+void FixedStepSimulation::SetLead(double lead)
+{
+	m_Lead.store(std::max(0.0, std::min(lead, MAX_SIMULATION_LEAD)));
+}
+
+float FixedStepSimulation::Interpolate(double displayTime)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	double span = m_Time[1] - m_Time[0];
+	m_Alpha = (span > 0.0) ? static_cast<float>(std::max(0.0, std::min((displayTime - m_Time[0]) / span, 1.0))) : 1.0f;
+	for (size_t i = 0; i < m_Array.size(); i++)
+	{
+		Array& array = m_Array[i];
+		const float *previous = array.State[0].data();
+		const float *latest = array.State[1].data();
+		for (int j = 0; j < array.Count; j++)
+		{
+			array.p_Display[j] = previous[j] + (latest[j] - previous[j]) * m_Alpha;
+		}
+	}
+	return m_Alpha;
+}
+
+void FixedStepSimulation::Run()
+{
+	ThreadScheduling::Apply(THREAD_SIMULATION);
+	WaitTimer timer;
+	double time = m_StepTime.load();
+	while (m_IsRunning.load())
+	{
+		double now = timer.WaitUntil([this]() { return m_Clock() + m_Lead.load(); }, time, m_IsRunning);
+		if (!m_IsRunning.load())
+		{
+			break;
+		}
+
+		// after a stall (e.g. a breakpoint) the steps restart from now
+		// instead of catching up
+		ThreadScheduling::RecordLatency(THREAD_SIMULATION, now - time);
+		ThreadScheduling::Apply(THREAD_SIMULATION);
+		if (now - time > 4.0 * m_Interval)
+		{
+			time = now;
+		}
+
+		m_StepTime.store(time + m_Interval);
+		m_Step();
+		time += m_Interval;
+		StoreStep(time);
+	}
+}
+
+void FixedStepSimulation::StoreStep(double time)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Time[0] = m_Time[1];
+	m_Time[1] = time;
+	for (size_t i = 0; i < m_Array.size(); i++)
+	{
+		Array& array = m_Array[i];
+		if (array.Count == 0)
+		{
+			continue;
+		}
+		array.State[0].swap(array.State[1]);
+		memcpy(array.State[1].data(), array.p_Source, sizeof(float) * array.Count);
+	}
+}
@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// simulation.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// upper limit of the lead of the simulation over the display (seconds)
+const double MAX_SIMULATION_LEAD = 0.1;
+
+// Fixed-timestep driver of the app simulation. Step k advances the state to
+// time t0 + k * interval and is run on the simulation thread once the clock
+// plus the lead (the latency of the display) reaches the previous step time,
+// so that the two latest states bracket the display time of the next frame.
+// Registered float arrays are copied after each step and interpolated for
+// the display.
+class FixedStepSimulation
+{
+public:
+	FixedStepSimulation();
+	~FixedStepSimulation();
+
+	void Start(double rate, std::function<void()> step, std::function<double()> clock);
+	void Stop();
+	bool IsRunning() const { return m_IsRunning.load(); }
+	bool IsSimulationThread() const { return IsRunning() && (std::this_thread::get_id() == m_Thread.get_id()); }
+
+	// source is written by the step function, display is read by the draw function
+	int  RegisterArray(float *source, float *display, int count);
+	void UnregisterArray(int arrayID);
+
+	// display thread
+	void  SetLead(double lead);
+	float Interpolate(double displayTime); // fills the display arrays and returns the factor
+
+	double stepTime() const { return m_StepTime.load(); } // time the running step advances to
+	double interval() const { return m_Interval; }
+	float  alpha() const { return m_Alpha; }
+
+private:
+	struct Array
+	{
+		float             *p_Source;
+		float             *p_Display;
+		int                Count;
+		std::vector<float> State[2]; // previous, latest step
+	};
+
+	std::thread           m_Thread;
+	std::atomic<bool>     m_IsRunning;
+	std::function<void()> m_Step;
+	std::function<double()> m_Clock;
+	double                m_Interval;
+	std::atomic<double>   m_Lead;
+	std::atomic<double>   m_StepTime;
+
+	std::mutex            m_Mutex; // arrays and step times
+	std::vector<Array>    m_Array; // Count == 0: unregistered
+	double                m_Time[2];
+	float                 m_Alpha;
+
+	void Run();
+	void StoreStep(double time);
+};
@@ -0,0 +1,202 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// frame_task.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "frame_task.h"
+
+#include <algorithm>
+
+namespace
+{
+	// weight of the latest frame in the averaged frame period
+	const double FRAME_PERIOD_SMOOTHING = 0.1;
+
+	double Seconds(std::chrono::steady_clock::duration duration)
+	{
+		return std::chrono::duration<double>(duration).count();
+	}
+
+	// the scheduler running steps on this thread
+	thread_local const FrameTaskScheduler *t_Running = nullptr;
+}
+
+FrameTaskScheduler::FrameTaskScheduler()
+{
+	m_NextID = 1;
+	m_Rotation = 0;
+	p_Current = nullptr;
+	m_MaxBudget = FRAME_TASK_DEFAULT_BUDGET;
+	m_Budget = FRAME_TASK_MIN_BUDGET;
+	m_FramePeriod = 0.0;
+	m_FrameWork = 0.0;
+	m_RunTime = 0.0;
+	m_FrameStart = Clock::now();
+	m_Deadline = m_FrameStart;
+	m_IsFirstFrame = true;
+}
+
+int FrameTaskScheduler::Add(Step step)
+{
+	if (!step)
+	{
+		return 0;
+	}
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	Task task;
+	task.ID = m_NextID++;
+	task.m_Step = std::move(step);
+	task.IsWaiting = false;
+	m_Added.push_back(std::move(task));
+	return m_Added.back().ID;
+}
+
+void FrameTaskScheduler::Cancel(int taskID)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Cancelled.push_back(taskID);
+}
+
+bool FrameTaskScheduler::IsRunning(int taskID)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto isTask = [taskID](const Task& task) { return task.ID == taskID; };
+	if (std::find(m_Cancelled.begin(), m_Cancelled.end(), taskID) != m_Cancelled.end())
+	{
+		return false;
+	}
+	return std::any_of(m_Added.begin(), m_Added.end(), isTask) || std::any_of(m_Tasks.begin(), m_Tasks.end(), isTask);
+}
+
+void FrameTaskScheduler::SetMaxBudget(double seconds)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_MaxBudget = std::max(seconds, FRAME_TASK_MIN_BUDGET);
+}
+
+void FrameTaskScheduler::BeginFrame()
+{
+	Clock::time_point now = Clock::now();
+	double period = Seconds(now - m_FrameStart);
+	if (m_IsFirstFrame)
+	{
+		m_IsFirstFrame = false;
+	}
+	else if (m_FramePeriod == 0.0)
+	{
+		m_FramePeriod = period;
+	}
+	else
+	{
+		m_FramePeriod += (period - m_FramePeriod) * FRAME_PERIOD_SMOOTHING;
+	}
+	m_FrameStart = now;
+	m_RunTime = 0.0;
+}
+
+void FrameTaskScheduler::Run()
+{
+	double maxBudget;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		maxBudget = m_MaxBudget;
+		for (Task& task : m_Added)
+		{
+			m_Tasks.push_back(std::move(task));
+		}
+		m_Added.clear();
+		for (int taskID : m_Cancelled)
+		{
+			m_Tasks.erase(std::remove_if(m_Tasks.begin(), m_Tasks.end(),
+				[taskID](const Task& task) { return task.ID == taskID; }), m_Tasks.end());
+		}
+		m_Cancelled.clear();
+	}
+	if (m_Tasks.empty())
+	{
+		return;
+	}
+
+	// what the display thread did not use of the previous frame
+	Clock::time_point start = Clock::now();
+	m_Budget = std::max(FRAME_TASK_MIN_BUDGET, std::min(m_FramePeriod - m_FrameWork - FRAME_TASK_MARGIN, maxBudget));
+	m_Deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_Budget));
+
+	// passes over the tasks, starting with a different one in each frame so
+	// that the first step of a frame is not always given to the same task
+	for (Task& task : m_Tasks)
+	{
+		task.IsWaiting = false;
+	}
+	size_t first = m_Rotation++ % m_Tasks.size();
+	std::vector<int> finished;
+	bool isStepped = true;
+	while (isStepped)
+	{
+		isStepped = false;
+		for (size_t i = 0; i < m_Tasks.size(); i++)
+		{
+			Task& task = m_Tasks[(first + i) % m_Tasks.size()];
+			if (task.IsWaiting)
+			{
+				continue;
+			}
+			if (Clock::now() >= m_Deadline)
+			{
+				isStepped = false;
+				break;
+			}
+			p_Current = &task;
+			t_Running = this;
+			bool isMore = task.m_Step();
+			t_Running = nullptr;
+			p_Current = nullptr;
+			if (!isMore)
+			{
+				task.IsWaiting = true;
+				finished.push_back(task.ID);
+			}
+			isStepped = true;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (int taskID : finished)
+		{
+			m_Tasks.erase(std::remove_if(m_Tasks.begin(), m_Tasks.end(),
+				[taskID](const Task& task) { return task.ID == taskID; }), m_Tasks.end());
+		}
+	}
+	m_RunTime += Seconds(Clock::now() - start);
+}
+
+void FrameTaskScheduler::EndWork()
+{
+	m_FrameWork = Seconds(Clock::now() - m_FrameStart) - m_RunTime;
+}
+
+double FrameTaskScheduler::TimeLeft() const
+{
+	if (t_Running != this)
+	{
+		return 0.0;
+	}
+	return std::max(0.0, Seconds(m_Deadline - Clock::now()));
+}
+
+void FrameTaskScheduler::WaitNextFrame()
+{
+	if (t_Running == this)
+	{
+		p_Current->IsWaiting = true;
+	}
+}
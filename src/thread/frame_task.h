@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// frame_task.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// time given to the frame tasks in each frame (seconds)
+const double FRAME_TASK_MIN_BUDGET = 0.0005;     // even when the frame has no time left
+const double FRAME_TASK_DEFAULT_BUDGET = 0.004;  // upper limit, CAVESetFrameTaskBudget()
+const double FRAME_TASK_MARGIN = 0.001;          // kept free before the frame is submitted
+
+// Incremental work run by the display thread in the time left in each frame.
+//
+// A task is a step function called repeatedly, round robin with the other
+// tasks, until the budget of the frame is used; it returns false once it is
+// finished. A step checks TimeLeft() to split its work and calls
+// WaitNextFrame() to be resumed in the next frame only. The budget is the
+// frame period minus the display thread's own work in the previous frame,
+// between FRAME_TASK_MIN_BUDGET and the configured upper limit. Steps run with
+// the GL context current and without locks against the draw callback.
+class FrameTaskScheduler
+{
+public:
+	typedef std::function<bool()> Step; // true: more work left
+
+	FrameTaskScheduler();
+
+	int  Add(Step step);        // any thread, returns the task ID (0: none)
+	void Cancel(int taskID);    // any thread, the step is not called again
+	bool IsRunning(int taskID); // any thread
+	void SetMaxBudget(double seconds);
+
+	// display thread, once per frame
+	void BeginFrame();
+	void Run();
+	void EndWork(); // the frame is complete but for its submission
+
+	// in a step (no effect on other threads)
+	double TimeLeft() const; // seconds, 0 outside a step
+	void   WaitNextFrame();
+
+	double budget() const { return m_Budget; } // of the latest frame
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Task
+	{
+		int  ID;
+		Step m_Step;
+		bool IsWaiting; // for the next frame
+	};
+
+	std::mutex        m_Mutex;  // m_Added, m_Cancelled, IDs in m_Tasks
+	std::vector<Task> m_Added;
+	std::vector<int>  m_Cancelled;
+	std::vector<Task> m_Tasks;  // display thread
+	int               m_NextID;
+	size_t            m_Rotation;
+	Task             *p_Current; // whose step is running
+
+	double            m_MaxBudget;
+	double            m_Budget;
+	double            m_FramePeriod; // averaged
+	double            m_FrameWork;   // previous frame, without the tasks
+	double            m_RunTime;     // of the tasks in this frame
+	Clock::time_point m_FrameStart;
+	Clock::time_point m_Deadline;
+	bool              m_IsFirstFrame;
+};
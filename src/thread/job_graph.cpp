@@ -0,0 +1,195 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// job_graph.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "job_graph.h"
+
+#include <iostream>
+
+namespace
+{
+	// a job ID is the batch in the upper bits and the index in the batch + 1
+	const int JOB_INDEX_BITS = 24;
+
+	JobID MakeID(long long batch, size_t index)
+	{
+		return (batch << JOB_INDEX_BITS) | static_cast<long long>(index + 1);
+	}
+
+	// the batch of the job being run by this thread, -1: not in a job
+	thread_local long long t_JobBatch = -1;
+}
+
+JobGraph::JobGraph(ThreadPool *pool) : p_Pool(pool), m_NumCompleted(0)
+{
+	m_Batch.store(1);
+}
+
+JobGraph::~JobGraph()
+{
+	JoinFrame();
+	JoinFrame();
+}
+
+JobID JobGraph::Submit(std::function<void()> function, const JobID *dependencies, int numDependencies)
+{
+	if (!function)
+	{
+		return 0;
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (!m_Groups[0])
+	{
+		// the workers are not started before a job needs them
+		ThreadPool& pool = (p_Pool != nullptr) ? *p_Pool : ThreadPool::Instance();
+		m_Groups[0].reset(new TaskGroup(pool));
+		m_Groups[1].reset(new TaskGroup(pool));
+	}
+	long long batch = (t_JobBatch >= 0) ? t_JobBatch : m_Batch.load();
+	std::deque<Job>& jobs = m_Jobs[batch & 1];
+	if (jobs.size() + 1 >= (static_cast<size_t>(1) << JOB_INDEX_BITS))
+	{
+		std::cout << "CLCL: Too many jobs in one frame." << std::endl;
+		return 0;
+	}
+	jobs.emplace_back();
+	Job *job = &jobs.back();
+	JobID id = MakeID(batch, jobs.size() - 1);
+	job->m_Function = std::move(function);
+	job->Remaining.store(1);
+	job->m_Batch = batch;
+	job->IsDone = false;
+	for (int i = 0; i < numDependencies; i++)
+	{
+		Job *dependency = Find(dependencies[i]);
+		if (dependency != nullptr)
+		{
+			dependency->m_Successors.push_back(job);
+			job->Remaining.fetch_add(1);
+		}
+	}
+
+	// the job can run once the submission is counted out; in the lock,
+	// so that JoinFrame() finds it in the group of its batch
+	if (job->Remaining.fetch_sub(1) == 1)
+	{
+		Schedule(job);
+	}
+	return id;
+}
+
+JobGraph::Job* JobGraph::Find(JobID id)
+{
+	long long batch = id >> JOB_INDEX_BITS;
+	size_t index = static_cast<size_t>(id & ((1LL << JOB_INDEX_BITS) - 1));
+	long long current = m_Batch.load();
+	if ((id <= 0) || (index == 0) || (batch > current) || (batch < current - 1))
+	{
+		return nullptr; // older batches are all joined
+	}
+	std::deque<Job>& jobs = m_Jobs[batch & 1];
+	if (index > jobs.size() || jobs[index - 1].IsDone)
+	{
+		return nullptr;
+	}
+	return &jobs[index - 1];
+}
+
+bool JobGraph::IsDone(JobID id)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return Find(id) == nullptr;
+}
+
+void JobGraph::Wait(JobID id)
+{
+	for (;;)
+	{
+		long long numCompleted;
+		TaskGroup *group;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (Find(id) == nullptr)
+			{
+				return;
+			}
+			numCompleted = m_NumCompleted;
+			group = m_Groups[(id >> JOB_INDEX_BITS) & 1].get(); // the job exists, so the groups do
+		}
+
+		// help with the queued jobs of the frame, otherwise sleep until a job
+		// completes (which may also schedule the awaited job)
+		if (!group->RunOne())
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [this, numCompleted]() { return m_NumCompleted != numCompleted; });
+		}
+	}
+}
+
+void JobGraph::Schedule(Job *job)
+{
+	m_Groups[job->m_Batch & 1]->Spawn([this, job]()
+	{
+		long long outer = t_JobBatch;
+		t_JobBatch = job->m_Batch;
+		job->m_Function();
+		t_JobBatch = outer;
+		Complete(job);
+	});
+}
+
+void JobGraph::Complete(Job *job)
+{
+	std::vector<Job*> successors;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		job->IsDone = true;
+		job->m_Function = nullptr; // release the captures now
+		successors.swap(job->m_Successors);
+	}
+	// a successor may belong to the next frame, so it is scheduled in its own
+	// batch, before this job is counted out of its group
+	for (Job *successor : successors)
+	{
+		if (successor->Remaining.fetch_sub(1) == 1)
+		{
+			Schedule(successor);
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_NumCompleted++;
+	}
+	m_Condition.notify_all();
+}
+
+void JobGraph::JoinFrame()
+{
+	TaskGroup *group;
+	{
+		// later submissions go to the next frame
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		long long batch = m_Batch.load();
+		m_Jobs[(batch + 1) & 1].clear(); // joined at the previous JoinFrame()
+		m_Batch.store(batch + 1);
+		group = m_Groups[batch & 1].get();
+	}
+
+	// help with the jobs of the frame (and their sub-jobs), then sleep until
+	// the running ones are done
+	if (group != nullptr)
+	{
+		group->Join();
+	}
+}
@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// job_graph.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "thread_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+typedef long long JobID; // 0: no job
+
+// Jobs with dependencies, run on the worker pool and joined once per frame.
+//
+// Jobs submitted during frame N run while the display thread renders frame N
+// and are all complete when JoinFrame() at the end of frame N returns, so the
+// next frame can use their results. A job runs after all of its dependencies;
+// jobs submitted by a job belong to the frame of that job.
+class JobGraph
+{
+public:
+	explicit JobGraph(ThreadPool *pool = nullptr); // nullptr: ThreadPool::Instance() at the first Submit()
+	~JobGraph();
+
+	JobID Submit(std::function<void()> function, const JobID *dependencies, int numDependencies);
+	bool  IsDone(JobID job);
+	void  Wait(JobID job);      // runs other jobs of its frame meanwhile
+	void  JoinFrame();          // display thread, at the end of each frame
+
+	long long batch() const { return m_Batch.load(); }
+
+private:
+	struct Job
+	{
+		std::function<void()> m_Function;
+		std::atomic<int>      Remaining; // dependencies + 1 while being submitted
+		std::vector<Job*>     m_Successors;
+		long long             m_Batch;   // frame the job belongs to
+		bool                  IsDone;
+	};
+
+	ThreadPool                *p_Pool;
+	std::mutex                 m_Mutex;      // jobs, successors, IsDone and m_NumCompleted
+	std::condition_variable    m_Condition;  // a job has completed
+	long long                  m_NumCompleted;
+	std::atomic<long long>     m_Batch;      // frame the new jobs belong to
+	std::deque<Job>            m_Jobs[2];    // of the current and the previous batch
+	std::unique_ptr<TaskGroup> m_Groups[2];  // the scheduled jobs of each batch, created at the first Submit()
+
+	Job* Find(JobID job); // nullptr if the job is complete (or unknown)
+	void Schedule(Job *job);
+	void Complete(Job *job);
+};
@@ -0,0 +1,447 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// scheduling.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "scheduling.h"
+#include "thread_pool.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX // to use "std::max()"
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+namespace
+{
+	const char* ROLE_NAMES[THREAD_ROLE_COUNT] = {
+		"display", "tracker", "camera", "worker", "simulation", "loader" };
+
+	const double LATENCY_WINDOW = 1.0;       // seconds
+	const int    LATENCY_BINS = 24;          // bin i: below 2^i microseconds
+	const double PERIOD_SMOOTHING = 0.05;    // weight of the latest interval
+
+	struct Role
+	{
+		std::atomic<long long> Count;
+		std::atomic<long long> TotalNs;
+		std::atomic<long long> MaxNs;
+		std::atomic<long long> Bins[LATENCY_BINS];
+
+		// RecordPeriod(), by the one thread of the role
+		double LastTime;
+		double Period;
+	};
+
+	Role s_Role[THREAD_ROLE_COUNT];
+
+	// policies and the latency of the latest window
+	std::mutex        s_Mutex;
+	ThreadPolicy      s_Policy[THREAD_ROLE_COUNT] = {
+		{ 0, SCHEDULING_DEFAULT, false }, // display
+		{ 0, SCHEDULING_HIGH, false },    // tracker (it samples at a fixed rate)
+		{ 0, SCHEDULING_DEFAULT, false }, // camera
+		{ 0, SCHEDULING_DEFAULT, false }, // worker
+		{ 0, SCHEDULING_DEFAULT, false }, // simulation
+		{ 0, SCHEDULING_DEFAULT, false }, // loader
+	};
+	std::atomic<int>  s_Generation(0);
+	SchedulingLatency s_Latency[THREAD_ROLE_COUNT];
+	double            s_WindowStart = -1.0;
+	double            s_LogInterval = 0.0;
+	double            s_LastLog = 0.0;
+
+	thread_local int t_Role = -1;
+	thread_local int t_Generation = -1;
+
+	bool IsValid(int role)
+	{
+		return (role >= 0) && (role < THREAD_ROLE_COUNT);
+	}
+
+	// the first "count" processors of the mask
+	unsigned long long FirstProcessors(unsigned long long mask, int count)
+	{
+		unsigned long long first = 0;
+		for (int i = 0; (i < 64) && (count > 0); i++)
+		{
+			unsigned long long bit = 1ULL << i;
+			if (mask & bit)
+			{
+				first |= bit;
+				count--;
+			}
+		}
+		return first;
+	}
+
+#ifdef _WIN32
+	unsigned long long ProcessMask()
+	{
+		DWORD_PTR processMask, systemMask;
+		if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+		{
+			return 0;
+		}
+		return static_cast<unsigned long long>(processMask);
+	}
+
+	bool SetAffinity(unsigned long long mask)
+	{
+		return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(mask)) != 0;
+	}
+
+	void SetIdealProcessor(unsigned long long mask)
+	{
+		for (DWORD i = 0; i < 64; i++)
+		{
+			if (mask & (1ULL << i))
+			{
+				SetThreadIdealProcessor(GetCurrentThread(), i);
+				return;
+			}
+		}
+	}
+
+	bool SetPriority(int priority)
+	{
+		static const int PRIORITIES[] = {
+			THREAD_PRIORITY_NORMAL, THREAD_PRIORITY_BELOW_NORMAL, THREAD_PRIORITY_NORMAL,
+			THREAD_PRIORITY_ABOVE_NORMAL, THREAD_PRIORITY_HIGHEST, THREAD_PRIORITY_TIME_CRITICAL };
+		if (priority == SCHEDULING_REALTIME)
+		{
+			// time critical in a normal process is still below the real-time range;
+			// the whole process is raised once (not to REALTIME_PRIORITY_CLASS,
+			// which would starve the input and the compositor)
+			DWORD priorityClass = GetPriorityClass(GetCurrentProcess());
+			if ((priorityClass != HIGH_PRIORITY_CLASS) && (priorityClass != REALTIME_PRIORITY_CLASS))
+			{
+				if (SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS))
+				{
+					std::cout << "CLCL: process priority raised to high for real-time threads." << std::endl;
+				}
+			}
+		}
+		return SetThreadPriority(GetCurrentThread(), PRIORITIES[priority]) != 0;
+	}
+#elif defined(__linux__)
+	unsigned long long ProcessMask()
+	{
+		// the mask of the main thread, which CLCL does not change
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		if (sched_getaffinity(getpid(), sizeof(set), &set) != 0)
+		{
+			return 0;
+		}
+		unsigned long long mask = 0;
+		for (int i = 0; i < 64; i++)
+		{
+			if (CPU_ISSET(i, &set))
+			{
+				mask |= 1ULL << i;
+			}
+		}
+		return mask;
+	}
+
+	bool SetAffinity(unsigned long long mask)
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int i = 0; i < 64; i++)
+		{
+			if (mask & (1ULL << i))
+			{
+				CPU_SET(i, &set);
+			}
+		}
+		return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+	}
+
+	void SetIdealProcessor(unsigned long long)
+	{
+		// no soft affinity on Linux
+	}
+
+	bool SetPriority(int priority)
+	{
+		sched_param param;
+		if (priority == SCHEDULING_REALTIME)
+		{
+			param.sched_priority = SCHEDULING_FIFO_PRIORITY; // needs CAP_SYS_NICE or an rtprio limit
+			return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+		}
+		static const int NICE[] = { 0, 5, 0, -5, -10 };
+		param.sched_priority = 0;
+		bool isSet = (pthread_setschedparam(pthread_self(), SCHED_OTHER, &param) == 0);
+		return (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), NICE[priority]) == 0) && isSet;
+	}
+#else
+	unsigned long long ProcessMask() { return 0; }
+	bool SetAffinity(unsigned long long) { return false; }
+	void SetIdealProcessor(unsigned long long) {}
+	bool SetPriority(int) { return false; }
+#endif
+
+	float Milliseconds(long long nanoseconds)
+	{
+		return static_cast<float>(nanoseconds * 1.0e-6);
+	}
+}
+
+void ThreadScheduling::SetPolicy(int role, const ThreadPolicy& policy)
+{
+	if (!IsValid(role))
+	{
+		return;
+	}
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	s_Policy[role] = policy;
+	s_Policy[role].Priority = std::max(static_cast<int>(SCHEDULING_DEFAULT), std::min(policy.Priority, static_cast<int>(SCHEDULING_REALTIME)));
+	s_Generation.fetch_add(1);
+}
+
+void ThreadScheduling::GetPolicy(int role, ThreadPolicy& policy)
+{
+	if (IsValid(role))
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		policy = s_Policy[role];
+	}
+}
+
+void ThreadScheduling::Apply(int role)
+{
+	int generation = s_Generation.load();
+	if (!IsValid(role) || ((t_Role == role) && (t_Generation == generation)))
+	{
+		return;
+	}
+	bool isFirst = (t_Role != role);
+	t_Role = role;
+	t_Generation = generation;
+
+	ThreadPolicy policy;
+	unsigned long long isolated = 0;
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		policy = s_Policy[role];
+		for (int i = 0; i < THREAD_ROLE_COUNT; i++)
+		{
+			if ((i != role) && s_Policy[i].IsIsolated)
+			{
+				isolated |= s_Policy[i].AffinityMask;
+			}
+		}
+	}
+
+	unsigned long long processMask = ProcessMask();
+	if (processMask != 0)
+	{
+		unsigned long long mask;
+		if (policy.AffinityMask != 0)
+		{
+			mask = policy.AffinityMask & processMask;
+		}
+		else if ((isolated == 0) && (role == THREAD_WORKER))
+		{
+			mask = processMask & ~FirstProcessors(processMask, THREAD_POOL_RESERVED_CORES);
+		}
+		else
+		{
+			mask = processMask & ~isolated;
+		}
+		if (mask == 0)
+		{
+			std::cout << "CLCL: no processor left for the " << ROLE_NAMES[role] << " thread, its affinity is not changed." << std::endl;
+		}
+		else if ((mask != processMask) || !isFirst)
+		{
+			if (!SetAffinity(mask))
+			{
+				std::cout << "CLCL: failed to set the affinity of the " << ROLE_NAMES[role] << " thread." << std::endl;
+			}
+		}
+		if ((role == THREAD_DISPLAY) && (policy.AffinityMask == 0) && (isolated == 0))
+		{
+			SetIdealProcessor(FirstProcessors(processMask, THREAD_POOL_RESERVED_CORES));
+		}
+	}
+
+	if ((policy.Priority != SCHEDULING_DEFAULT) || !isFirst)
+	{
+		if (!SetPriority(policy.Priority))
+		{
+			std::cout << "CLCL: failed to set the priority of the " << ROLE_NAMES[role] << " thread." << std::endl;
+		}
+	}
+}
+
+double ThreadScheduling::Clock()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ThreadScheduling::RecordLatency(int role, double seconds)
+{
+	if (!IsValid(role))
+	{
+		return;
+	}
+	Role& state = s_Role[role];
+	long long nanoseconds = static_cast<long long>(std::max(seconds, 0.0) * 1.0e9);
+	int bin = 0;
+	for (long long microseconds = nanoseconds / 1000; (microseconds > 0) && (bin < LATENCY_BINS - 1); microseconds >>= 1)
+	{
+		bin++;
+	}
+	state.Count.fetch_add(1);
+	state.TotalNs.fetch_add(nanoseconds);
+	state.Bins[bin].fetch_add(1);
+	long long max = state.MaxNs.load();
+	while ((nanoseconds > max) && !state.MaxNs.compare_exchange_weak(max, nanoseconds))
+	{
+	}
+}
+
+void ThreadScheduling::RecordPeriod(int role)
+{
+	if (!IsValid(role))
+	{
+		return;
+	}
+	Role& state = s_Role[role];
+	double now = Clock();
+	if (state.LastTime > 0.0)
+	{
+		double interval = now - state.LastTime;
+		if (state.Period <= 0.0)
+		{
+			state.Period = interval;
+		}
+		else
+		{
+			RecordLatency(role, interval - state.Period);
+			// a stall does not move the usual period
+			state.Period += (std::min(interval, 2.0 * state.Period) - state.Period) * PERIOD_SMOOTHING;
+		}
+	}
+	state.LastTime = now;
+}
+
+void ThreadScheduling::GetLatency(int role, SchedulingLatency& latency)
+{
+	if (IsValid(role))
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		latency = s_Latency[role];
+	}
+}
+
+const char* ThreadScheduling::name(int role)
+{
+	return IsValid(role) ? ROLE_NAMES[role] : "";
+}
+
+void ThreadScheduling::EndFrame(double time)
+{
+	bool isLogTime = false;
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		if (s_WindowStart < 0.0)
+		{
+			s_WindowStart = time;
+			s_LastLog = time;
+		}
+		if (time - s_WindowStart >= LATENCY_WINDOW)
+		{
+			for (int i = 0; i < THREAD_ROLE_COUNT; i++)
+			{
+				Role& state = s_Role[i];
+				SchedulingLatency& latency = s_Latency[i];
+				long long count = state.Count.exchange(0);
+				long long total = state.TotalNs.exchange(0);
+				long long bins[LATENCY_BINS];
+				for (int j = 0; j < LATENCY_BINS; j++)
+				{
+					bins[j] = state.Bins[j].exchange(0);
+				}
+				latency.Count = count;
+				latency.MeanMs = (count > 0) ? Milliseconds(total / count) : 0.0f;
+				latency.MaxMs = Milliseconds(state.MaxNs.exchange(0));
+
+				// upper bound of the bin of the 99th percentile
+				long long rank = count - count / 100;
+				latency.P99Ms = 0.0f;
+				for (long long j = 0, sum = 0; (j < LATENCY_BINS) && (count > 0); j++)
+				{
+					sum += bins[j];
+					if (sum >= rank)
+					{
+						latency.P99Ms = std::min(static_cast<float>((1LL << j) * 1.0e-3), latency.MaxMs);
+						break;
+					}
+				}
+			}
+			s_WindowStart = time;
+		}
+		if ((s_LogInterval > 0.0) && (time - s_LastLog >= s_LogInterval))
+		{
+			s_LastLog = time;
+			isLogTime = true;
+		}
+	}
+
+	if (isLogTime)
+	{
+		Log();
+	}
+}
+
+void ThreadScheduling::SetLogInterval(double seconds)
+{
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	s_LogInterval = (seconds > 0.0) ? seconds : 0.0;
+}
+
+void ThreadScheduling::Log()
+{
+	std::cout << "CLCL: scheduling latency (wake-ups / s, mean / p99 / max ms)" << std::endl;
+	for (int i = 0; i < THREAD_ROLE_COUNT; i++)
+	{
+		SchedulingLatency latency;
+		GetLatency(i, latency);
+		if (latency.Count == 0)
+		{
+			continue;
+		}
+		std::cout << "  " << std::left << std::setw(12) << ROLE_NAMES[i] << std::right << std::fixed
+			<< std::setw(8) << latency.Count << std::setprecision(3)
+			<< std::setw(9) << latency.MeanMs << " /" << std::setw(8) << latency.P99Ms
+			<< " /" << std::setw(8) << latency.MaxMs << std::endl;
+	}
+	std::cout.unsetf(std::ios::floatfield);
+	std::cout << std::setprecision(6);
+}
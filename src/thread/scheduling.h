@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// scheduling.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+typedef enum {
+	THREAD_DISPLAY = 0, // render loop
+	THREAD_TRACKER,     // high-rate tracking samples
+	THREAD_CAMERA,      // camera capture
+	THREAD_WORKER,      // worker pool
+	THREAD_SIMULATION,  // fixed-step simulation
+	THREAD_LOADER,      // resource uploads
+	THREAD_ROLE_COUNT
+} THREAD_ROLE;
+
+typedef enum {
+	SCHEDULING_DEFAULT = 0, // as created
+	SCHEDULING_LOW,
+	SCHEDULING_NORMAL,
+	SCHEDULING_HIGH,
+	SCHEDULING_HIGHEST,
+	SCHEDULING_REALTIME     // SCHED_FIFO on Linux, time critical in a high priority process on Windows
+} SCHEDULING_PRIORITY;
+
+// priority of SCHED_FIFO threads on Linux
+const int SCHEDULING_FIFO_PRIORITY = 50;
+
+struct ThreadPolicy
+{
+	unsigned long long AffinityMask; // logical processors, 0: those not isolated for others
+	int                Priority;     // SCHEDULING_PRIORITY
+	bool               IsIsolated;   // the threads of other roles keep off AffinityMask
+};
+
+struct SchedulingLatency
+{
+	long long Count; // wake-ups in the latest window
+	float     MeanMs;
+	float     P99Ms;
+	float     MaxMs;
+};
+
+// Affinity and priority of the CLCL threads by role, and the latency with
+// which they are scheduled.
+//
+// Every thread calls Apply() with its role when it starts and again in its
+// loop; a policy set later is applied there (a check of one atomic when
+// nothing changed). Without any policy the workers keep off the first
+// THREAD_POOL_RESERVED_CORES processors, which the display thread prefers.
+// The latency is how late a thread runs after it should have: after a timed
+// wait, after being woken for a task, or behind its usual period.
+class ThreadScheduling
+{
+public:
+	static void SetPolicy(int role, const ThreadPolicy& policy);
+	static void GetPolicy(int role, ThreadPolicy& policy);
+	static void Apply(int role);
+
+	static double Clock(); // seconds
+	static void RecordLatency(int role, double seconds);
+	static void RecordPeriod(int role); // once per iteration of a periodic thread (one thread per role)
+	static void GetLatency(int role, SchedulingLatency& latency);
+	static const char* name(int role);
+
+	// called by the display thread once per frame
+	static void EndFrame(double time);
+	static void SetLogInterval(double seconds); // 0: no log
+	static void Log();
+};
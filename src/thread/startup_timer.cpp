@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// startup_timer.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "startup_timer.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+StartupTimer::StartupTimer()
+{
+	m_Start = Clock::now();
+}
+
+void StartupTimer::Start()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Start = Clock::now();
+	m_Phases.clear();
+}
+
+int StartupTimer::Begin(const char *name)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	Phase phase;
+	phase.Name = name;
+	phase.BeginTime = Now();
+	phase.EndTime = -1.0;
+	m_Phases.push_back(phase);
+	return static_cast<int>(m_Phases.size()) - 1;
+}
+
+void StartupTimer::End(int phase)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if ((phase >= 0) && (phase < static_cast<int>(m_Phases.size())))
+	{
+		m_Phases[phase].EndTime = Now();
+	}
+}
+
+void StartupTimer::Log()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	double total = 0.0;
+	double serial = 0.0; // if the phases had run one after another
+	std::cout << "CLCL: startup (begin - end, duration ms)" << std::endl;
+	for (const Phase& phase : m_Phases)
+	{
+		double end = (phase.EndTime < 0.0) ? Now() : phase.EndTime;
+		total = std::max(total, end);
+		serial += end - phase.BeginTime;
+		std::cout << "  " << std::left << std::setw(14) << phase.Name << std::right << std::fixed << std::setprecision(1)
+			<< std::setw(8) << phase.BeginTime * 1000.0 << " -" << std::setw(8) << end * 1000.0
+			<< std::setw(9) << (end - phase.BeginTime) * 1000.0 << ((phase.EndTime < 0.0) ? " (running)" : "") << std::endl;
+	}
+	std::cout << "  total " << total * 1000.0 << " ms (" << serial * 1000.0 << " ms one after another)" << std::endl;
+	std::cout.unsetf(std::ios::floatfield);
+	std::cout << std::setprecision(6);
+}
+
+double StartupTimer::Now() const
+{
+	return std::chrono::duration<double>(Clock::now() - m_Start).count();
+}
@@ -0,0 +1,48 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// startup_timer.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Start and end times of the startup phases, which may overlap on several
+// threads, relative to Start().
+class StartupTimer
+{
+public:
+	StartupTimer();
+
+	void Start();
+	int  Begin(const char *name); // any thread, returns the phase
+	void End(int phase);
+	void Log();                   // all phases and the total
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Phase
+	{
+		std::string Name;
+		double      BeginTime; // seconds from Start()
+		double      EndTime;   // < 0: running
+	};
+
+	std::mutex         m_Mutex;
+	Clock::time_point  m_Start;
+	std::vector<Phase> m_Phases;
+
+	double Now() const;
+};
@@ -0,0 +1,290 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// thread_pool.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "thread_pool.h"
+#include "scheduling.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+	thread_local const ThreadPool *t_WorkerOf = nullptr;
+	thread_local int t_WorkerIndex = -1;
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool) : m_Pool(pool)
+{
+	m_Pending.store(0);
+	m_Queued.store(0);
+}
+
+void TaskGroup::Spawn(std::function<void()> task)
+{
+	if (!task)
+	{
+		return;
+	}
+	m_Pending.fetch_add(1);
+	m_Pool.Push(std::move(task), this);
+}
+
+bool TaskGroup::RunOne()
+{
+	ThreadPool::Task task;
+	if (!m_Pool.Pop(m_Pool.IsWorkerThread() ? t_WorkerIndex : -1, task, this))
+	{
+		return false;
+	}
+	m_Pool.Run(task);
+	return true;
+}
+
+void TaskGroup::Join()
+{
+	while (m_Pending.load() > 0)
+	{
+		// help with the queued tasks of the group (other tasks could take
+		// long and delay the join), then sleep until the running ones finish
+		// or one of them spawns another
+		if (RunOne())
+		{
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Condition.wait(lock, [this]() { return (m_Pending.load() == 0) || (m_Queued.load() > 0); });
+	}
+	std::lock_guard<std::mutex> lock(m_Mutex); // the last Run() has released it, the group may be destroyed
+}
+
+ThreadPool& ThreadPool::Instance()
+{
+	static ThreadPool pool(std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - THREAD_POOL_RESERVED_CORES));
+	return pool;
+}
+
+ThreadPool::ThreadPool(int numWorkers) : m_IsStopping(false), m_NotifyTime(0.0)
+{
+	m_NumQueued.store(0);
+	for (int i = 0; i <= numWorkers; i++)
+	{
+		m_Queues.emplace_back(new Queue);
+	}
+	for (int i = 0; i < numWorkers; i++)
+	{
+		m_Workers.emplace_back(&ThreadPool::WorkerThread, this, i);
+	}
+	std::cout << "CLCL: " << numWorkers << " worker threads." << std::endl;
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+		m_IsStopping = true;
+	}
+	m_Condition.notify_all();
+	for (auto& worker : m_Workers)
+	{
+		worker.join();
+	}
+}
+
+bool ThreadPool::IsWorkerThread() const
+{
+	return t_WorkerOf == this;
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+	if (task)
+	{
+		Push(std::move(task), nullptr);
+	}
+}
+
+void ThreadPool::Push(std::function<void()> function, TaskGroup *group)
+{
+	// workers push to their own queue, other threads to the shared one
+	Queue& queue = *m_Queues[IsWorkerThread() ? t_WorkerIndex : numWorkers()];
+	{
+		std::lock_guard<std::mutex> lock(queue.m_Mutex);
+		queue.m_Tasks.push_back(Task{ std::move(function), group });
+		if (group != nullptr)
+		{
+			// while the task cannot be popped yet, so that the group is
+			// still alive; a joining thread runs it
+			{
+				std::lock_guard<std::mutex> groupLock(group->m_Mutex); // no wake-up is lost
+				group->m_Queued.fetch_add(1);
+			}
+			group->m_Condition.notify_all();
+		}
+	}
+	m_NumQueued.fetch_add(1);
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex); // no wake-up is lost
+		m_NotifyTime = ThreadScheduling::Clock();
+	}
+	m_Condition.notify_one();
+}
+
+bool ThreadPool::Pop(int index, Task& task, const TaskGroup *group)
+{
+	if ((m_NumQueued.load() == 0) || ((group != nullptr) && (group->m_Queued.load() == 0)))
+	{
+		return false;
+	}
+	// the newest or the oldest task of a queue, or of the group in it
+	auto take = [&](std::deque<Task>& tasks, bool isNewest)
+	{
+		const size_t count = tasks.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			auto queued = tasks.begin() + (isNewest ? count - 1 - i : i);
+			if ((group == nullptr) || (queued->p_Group == group))
+			{
+				task = std::move(*queued);
+				tasks.erase(queued);
+				m_NumQueued.fetch_sub(1);
+				if (task.p_Group != nullptr)
+				{
+					task.p_Group->m_Queued.fetch_sub(1);
+				}
+				return true;
+			}
+		}
+		return false;
+	};
+
+	const int numQueues = static_cast<int>(m_Queues.size());
+	if (index >= 0)
+	{
+		Queue& own = *m_Queues[index];
+		std::lock_guard<std::mutex> lock(own.m_Mutex);
+		if (take(own.m_Tasks, true))
+		{
+			return true;
+		}
+	}
+	// the shared queue first, then the other workers from the next one
+	for (int i = 0; i < numQueues; i++)
+	{
+		int victim = (i == 0) ? numQueues - 1 : (index + i + numQueues - 1) % (numQueues - 1);
+		if (victim == index)
+		{
+			continue;
+		}
+		Queue& queue = *m_Queues[victim];
+		std::lock_guard<std::mutex> lock(queue.m_Mutex);
+		if (take(queue.m_Tasks, false))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ThreadPool::RunOne()
+{
+	Task task;
+	if (!Pop(IsWorkerThread() ? t_WorkerIndex : -1, task))
+	{
+		return false;
+	}
+	Run(task);
+	return true;
+}
+
+void ThreadPool::Run(Task& task)
+{
+	task.m_Function();
+	if (task.p_Group != nullptr)
+	{
+		// under the mutex: the joining thread may destroy the group as soon
+		// as it sees m_Pending reach 0
+		TaskGroup& group = *task.p_Group;
+		std::lock_guard<std::mutex> lock(group.m_Mutex);
+		if (group.m_Pending.fetch_sub(1) == 1)
+		{
+			group.m_Condition.notify_all();
+		}
+	}
+}
+
+void ThreadPool::WorkerThread(int index)
+{
+	t_WorkerOf = this;
+	t_WorkerIndex = index;
+	ThreadScheduling::Apply(THREAD_WORKER);
+	for (;;)
+	{
+		Task task;
+		if (Pop(index, task))
+		{
+			Run(task);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(m_SleepMutex);
+		auto isWoken = [this]() { return m_IsStopping || (m_NumQueued.load() > 0); };
+		if (!isWoken())
+		{
+			m_Condition.wait(lock, isWoken);
+			ThreadScheduling::RecordLatency(THREAD_WORKER, ThreadScheduling::Clock() - m_NotifyTime);
+		}
+		if (m_IsStopping && (m_NumQueued.load() == 0))
+		{
+			return;
+		}
+		lock.unlock();
+		ThreadScheduling::Apply(THREAD_WORKER);
+	}
+}
+
+void ThreadPool::ParallelFor(int begin, int end, int grain, const std::function<void(int, int)>& function, int maxThreads)
+{
+	if (end <= begin)
+	{
+		return;
+	}
+	grain = std::max(1, grain);
+	int numChunks = (end - begin + grain - 1) / grain;
+	int numThreads = std::min(numChunks, numWorkers() + 1);
+	if (maxThreads > 0)
+	{
+		numThreads = std::min(numThreads, maxThreads);
+	}
+	if (numThreads <= 1)
+	{
+		function(begin, end);
+		return;
+	}
+
+	// the chunks are taken in order by the caller and numThreads - 1 helpers
+	std::atomic<int> nextChunk(0);
+	auto runChunks = [&]()
+	{
+		for (int chunk = nextChunk.fetch_add(1); chunk < numChunks; chunk = nextChunk.fetch_add(1))
+		{
+			int chunkBegin = begin + chunk * grain;
+			function(chunkBegin, std::min(end, chunkBegin + grain));
+		}
+	};
+	TaskGroup group(*this);
+	for (int t = 1; t < numThreads; t++)
+	{
+		group.Spawn(runChunks);
+	}
+	runChunks();
+	group.Join();
+}
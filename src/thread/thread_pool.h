@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// thread_pool.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// logical processors left to the display thread (and the OS) by the workers
+// unless affinities are set, see ThreadScheduling
+const int THREAD_POOL_RESERVED_CORES = 1;
+
+class ThreadPool;
+
+// Tasks spawned into a group are joined together. A thread waiting in Join()
+// runs the queued tasks of the group itself, so groups may be nested, and
+// sleeps while the rest of them run on other threads.
+class TaskGroup
+{
+public:
+	explicit TaskGroup(ThreadPool& pool);
+	~TaskGroup() { Join(); }
+
+	void Spawn(std::function<void()> task);
+	bool RunOne(); // runs a queued task of the group on the calling thread, false if none
+	void Join();
+
+private:
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	friend class ThreadPool;
+	ThreadPool&             m_Pool;
+	std::atomic<int>        m_Pending; // spawned and not finished
+	std::atomic<int>        m_Queued;  // of them in a queue
+	std::mutex              m_Mutex;
+	std::condition_variable m_Condition; // m_Pending reached 0 or a task was queued
+};
+
+// Fork/join worker pool shared by CLCL and the app. The workers are created
+// at the first use, one per logical processor except the reserved ones, and
+// are kept off the reserved processors so that they do not preempt the
+// display thread.
+//
+// Every worker has its own queue: it runs its newest task first and, when the
+// queue is empty, takes the oldest task of the shared queue (tasks pushed by
+// other threads) or steals the oldest task of another worker.
+class ThreadPool
+{
+public:
+	static ThreadPool& Instance();
+
+	ThreadPool(int numWorkers);
+	~ThreadPool();
+
+	// function(chunkBegin, chunkEnd) for chunks of "grain" indices (the last
+	// may be shorter) on up to maxThreads threads including the caller
+	void ParallelFor(int begin, int end, int grain, const std::function<void(int, int)>& function, int maxThreads = 0);
+
+	void Submit(std::function<void()> task); // not joined, see TaskGroup and JobGraph
+	bool RunOne(); // runs a queued task on the calling thread, false if none
+
+	int  numWorkers() const { return static_cast<int>(m_Workers.size()); }
+	bool IsWorkerThread() const;
+
+private:
+	friend class TaskGroup;
+
+	struct Task
+	{
+		std::function<void()> m_Function;
+		TaskGroup            *p_Group;
+	};
+
+	struct Queue
+	{
+		std::mutex       m_Mutex;
+		std::deque<Task> m_Tasks;
+	};
+
+	std::vector<std::thread> m_Workers;
+	std::vector<std::unique_ptr<Queue>> m_Queues; // one per worker, the last is shared
+	std::atomic<int>         m_NumQueued;
+	std::mutex               m_SleepMutex;
+	std::condition_variable  m_Condition;
+	bool                     m_IsStopping;
+	double                   m_NotifyTime; // of the latest wake-up, for the scheduling latency
+
+	void Push(std::function<void()> function, TaskGroup *group);
+	bool Pop(int index, Task& task, const TaskGroup *group = nullptr); // index: worker, -1: other threads; group: only its tasks
+	void Run(Task& task);
+	void WorkerThread(int index);
+};
@@ -0,0 +1,92 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// wait_timer.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "wait_timer.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX // to use "std::max()"
+#include <windows.h>
+#include <mmsystem.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+WaitTimer::WaitTimer()
+	: m_Timer(nullptr)
+	, m_IsPeriodRaised(false)
+{
+	m_Timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (m_Timer == nullptr) // before Windows 10 1803
+	{
+		m_IsPeriodRaised = (timeBeginPeriod(1) == TIMERR_NOERROR);
+		m_Timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+	}
+}
+
+WaitTimer::~WaitTimer()
+{
+	if (m_Timer != nullptr)
+	{
+		CloseHandle(m_Timer);
+	}
+	if (m_IsPeriodRaised)
+	{
+		timeEndPeriod(1);
+	}
+}
+
+void WaitTimer::Wait(double seconds)
+{
+	if (seconds <= 0.0)
+	{
+		return;
+	}
+	LARGE_INTEGER dueTime;
+	dueTime.QuadPart = -std::max(1LL, static_cast<long long>(seconds * 1.0e7)); // relative, in 100 ns
+	if ((m_Timer != nullptr) && SetWaitableTimer(m_Timer, &dueTime, 0, nullptr, nullptr, FALSE))
+	{
+		WaitForSingleObject(m_Timer, INFINITE);
+	}
+	else
+	{
+		Sleep(std::max(1ul, static_cast<unsigned long>(seconds * 1000.0)));
+	}
+}
+#else
+WaitTimer::WaitTimer()
+	: m_Timer(nullptr)
+	, m_IsPeriodRaised(false)
+{
+}
+
+WaitTimer::~WaitTimer()
+{
+}
+
+void WaitTimer::Wait(double seconds)
+{
+	if (seconds > 0.0)
+	{
+		std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+	}
+}
+#endif
@@ -0,0 +1,49 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// wait_timer.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+
+// Blocking waits with sub-millisecond resolution for the periodic threads
+// (tracker, simulation). On Windows a high-resolution waitable timer is used
+// (Windows 10 1803 or later), otherwise a waitable timer with the system timer
+// period raised to a millisecond. The thread never spins while it waits.
+// One per thread.
+class WaitTimer
+{
+public:
+	WaitTimer();
+	~WaitTimer();
+	WaitTimer(const WaitTimer&) = delete;
+	WaitTimer& operator=(const WaitTimer&) = delete;
+
+	void Wait(double seconds);
+
+	// waits until clock() reaches deadline or isRunning turns false,
+	// returns clock() at the wake-up
+	template <typename Clock>
+	double WaitUntil(Clock clock, double deadline, const std::atomic<bool>& isRunning)
+	{
+		double now;
+		while (((now = clock()) < deadline) && isRunning.load())
+		{
+			Wait(deadline - now);
+		}
+		return now;
+	}
+
+private:
+	void* m_Timer;          // HANDLE
+	bool  m_IsPeriodRaised; // timeBeginPeriod(1) for the fallback timer
+};
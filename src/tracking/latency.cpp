@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// latency.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "latency.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	// histogram range of each metric in milliseconds
+	const float HISTOGRAM_RANGE[LATENCY_METRIC_COUNT][2] = {
+		{   0.0f,  50.0f }, // LATENCY_SAMPLE_TO_SUBMIT
+		{   0.0f, 100.0f }, // LATENCY_MOTION_TO_PHOTON
+		{ -25.0f,  25.0f }, // LATENCY_PREDICTION_ERROR
+		{   0.0f, 200.0f }  // LATENCY_APP_DATA_AGE
+	};
+}
+
+LatencyStats::LatencyStats()
+{
+	memset(m_Trace, 0, sizeof(m_Trace));
+	m_Count = 0;
+	memset(m_Histogram, 0, sizeof(m_Histogram));
+	memset(m_NumSamples, 0, sizeof(m_NumSamples));
+	m_AppDataVersion = 0;
+	m_AppDataTime = 0.0;
+}
+
+long long LatencyStats::PublishAppData(double time)
+{
+	std::lock_guard<std::mutex> lock(m_AppDataMutex);
+	m_AppDataTime = time;
+	return ++m_AppDataVersion;
+}
+
+void LatencyStats::LatchAppData(long long& version, double& time)
+{
+	std::lock_guard<std::mutex> lock(m_AppDataMutex);
+	version = m_AppDataVersion;
+	time = m_AppDataTime;
+}
+
+void LatencyStats::Submit(const LatencyFrame& frame)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Trace[m_Count % LATENCY_TRACE_SIZE] = frame;
+	m_Count++;
+	AddSample(LATENCY_SAMPLE_TO_SUBMIT, frame.SubmitTime - frame.SampleTime);
+	if (frame.AppDataVersion > 0)
+	{
+		AddSample(LATENCY_APP_DATA_AGE, frame.SubmitTime - frame.AppDataTime);
+	}
+}
+
+void LatencyStats::SetMotionToPhoton(long long frame, double latency)
+{
+	if (latency <= 0.0)
+	{
+		return; // not measured by the runtime
+	}
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	// reported a few frames after the submission: search back from the latest
+	long long index = m_Count - 1;
+	while ((index >= 0) && (index >= m_Count - LATENCY_TRACE_SIZE) && (m_Trace[index % LATENCY_TRACE_SIZE].Frame > frame))
+	{
+		index--;
+	}
+	if ((index < 0) || (index < m_Count - LATENCY_TRACE_SIZE))
+	{
+		return;
+	}
+	LatencyFrame& entry = m_Trace[index % LATENCY_TRACE_SIZE];
+	if ((entry.Frame != frame) || (entry.DisplayTime != 0.0))
+	{
+		return; // not submitted, overwritten or already reported
+	}
+	entry.DisplayTime = entry.SampleTime + latency;
+	AddSample(LATENCY_MOTION_TO_PHOTON, latency);
+	if (entry.PredictedDisplayTime != 0.0)
+	{
+		AddSample(LATENCY_PREDICTION_ERROR, entry.DisplayTime - entry.PredictedDisplayTime);
+	}
+}
+
+int LatencyStats::GetTrace(LatencyFrame *frames, int maxCount)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	int count = static_cast<int>(std::min<long long>(std::min<long long>(m_Count, LATENCY_TRACE_SIZE), maxCount));
+	for (int i = 0; i < count; i++)
+	{
+		frames[i] = m_Trace[(m_Count - count + i) % LATENCY_TRACE_SIZE];
+	}
+	return count;
+}
+
+int LatencyStats::GetHistogram(int metric, int counts[LATENCY_HISTOGRAM_BINS], float *minMs, float *maxMs)
+{
+	if ((metric < 0) || (metric >= LATENCY_METRIC_COUNT))
+	{
+		return 0;
+	}
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	memcpy(counts, m_Histogram[metric], sizeof(int) * LATENCY_HISTOGRAM_BINS);
+	*minMs = HISTOGRAM_RANGE[metric][0];
+	*maxMs = HISTOGRAM_RANGE[metric][1];
+	return m_NumSamples[metric];
+}
+
+void LatencyStats::Reset()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	memset(m_Histogram, 0, sizeof(m_Histogram));
+	memset(m_NumSamples, 0, sizeof(m_NumSamples));
+}
+
+void LatencyStats::AddSample(int metric, double seconds)
+{
+	const float *range = HISTOGRAM_RANGE[metric];
+	double bin = (seconds * 1000.0 - range[0]) / (range[1] - range[0]) * LATENCY_HISTOGRAM_BINS;
+	int index = static_cast<int>(std::max(0.0, std::min(bin, LATENCY_HISTOGRAM_BINS - 1.0)));
+	m_Histogram[metric][index]++;
+	m_NumSamples[metric]++;
+}
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// latency.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <mutex>
+
+typedef enum {
+	LATENCY_SAMPLE_TO_SUBMIT = 0, // tracking sampled -> frame submitted
+	LATENCY_MOTION_TO_PHOTON,     // tracking sampled -> frame displayed
+	LATENCY_PREDICTION_ERROR,     // displayed - predicted display time
+	LATENCY_APP_DATA_AGE,         // app data published -> frame submitted
+	LATENCY_METRIC_COUNT
+} LATENCY_METRIC;
+
+// times of one frame in seconds (ovr_GetTimeInSeconds), 0 while unknown
+struct LatencyFrame
+{
+	long long Frame;
+	double    SampleTime;
+	double    PredictedDisplayTime;
+	double    SubmitTime;
+	double    DisplayTime;    // from the runtime's performance stats
+	long long AppDataVersion; // 0: never published
+	double    AppDataTime;
+};
+
+const int LATENCY_TRACE_SIZE = 512;
+const int LATENCY_HISTOGRAM_BINS = 100;
+
+// Per-frame latency trace and histograms. Frames are submitted by the display
+// thread; their display times arrive a few frames later from the runtime.
+class LatencyStats
+{
+public:
+	LatencyStats();
+
+	long long PublishAppData(double time); // a new version of the app data
+	void LatchAppData(long long& version, double& time);
+
+	void Submit(const LatencyFrame& frame);
+	void SetMotionToPhoton(long long frame, double latency); // seconds after SampleTime
+
+	// the latest frames, oldest first
+	int  GetTrace(LatencyFrame *frames, int maxCount);
+	// counts of [minMs, maxMs) in LATENCY_HISTOGRAM_BINS bins, the outliers in
+	// the first / last bin; returns the number of samples
+	int  GetHistogram(int metric, int counts[LATENCY_HISTOGRAM_BINS], float *minMs, float *maxMs);
+	void Reset();
+
+private:
+	std::mutex   m_Mutex;
+	LatencyFrame m_Trace[LATENCY_TRACE_SIZE];
+	long long    m_Count;
+	int          m_Histogram[LATENCY_METRIC_COUNT][LATENCY_HISTOGRAM_BINS];
+	int          m_NumSamples[LATENCY_METRIC_COUNT];
+
+	std::mutex   m_AppDataMutex;
+	long long    m_AppDataVersion;
+	double       m_AppDataTime;
+
+	void AddSample(int metric, double seconds);
+};
@@ -0,0 +1,303 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// pose_history.cpp
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "pose_history.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+	const int READ_RETRY = 4;
+
+	bool IsTracked(const PoseFrame& frame, int device)
+	{
+		return (frame.TrackedDevices & (1u << device)) != 0;
+	}
+}
+
+void InterpolatePose(const Pose& pose0, const Pose& pose1, float t, Pose& pose)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		pose.Position[i] = pose0.Position[i] + (pose1.Position[i] - pose0.Position[i]) * t;
+	}
+
+	// slerp along the shorter arc
+	const float *q0 = pose0.Orientation;
+	float q1[4] = { pose1.Orientation[0], pose1.Orientation[1], pose1.Orientation[2], pose1.Orientation[3] };
+	float cosTheta = q0[0] * q1[0] + q0[1] * q1[1] + q0[2] * q1[2] + q0[3] * q1[3];
+	if (cosTheta < 0.0f)
+	{
+		cosTheta = -cosTheta;
+		for (int i = 0; i < 4; i++)
+		{
+			q1[i] = -q1[i];
+		}
+	}
+
+	float w0 = 1.0f - t;
+	float w1 = t;
+	if (cosTheta < 0.9995f)
+	{
+		float theta = acosf(cosTheta);
+		float sinTheta = sinf(theta);
+		w0 = sinf((1.0f - t) * theta) / sinTheta;
+		w1 = sinf(t * theta) / sinTheta;
+	}
+
+	float length = 0.0f;
+	for (int i = 0; i < 4; i++)
+	{
+		pose.Orientation[i] = w0 * q0[i] + w1 * q1[i];
+		length += pose.Orientation[i] * pose.Orientation[i];
+	}
+	length = sqrtf(length);
+	for (int i = 0; i < 4; i++)
+	{
+		pose.Orientation[i] /= length;
+	}
+}
+
+void RotateVector(const float q[4], const float v[3], float out[3])
+{
+	// v + 2w (u x v) + 2 u x (u x v)
+	float tx = 2.0f * (q[1] * v[2] - q[2] * v[1]);
+	float ty = 2.0f * (q[2] * v[0] - q[0] * v[2]);
+	float tz = 2.0f * (q[0] * v[1] - q[1] * v[0]);
+	out[0] = v[0] + q[3] * tx + (q[1] * tz - q[2] * ty);
+	out[1] = v[1] + q[3] * ty + (q[2] * tx - q[0] * tz);
+	out[2] = v[2] + q[3] * tz + (q[0] * ty - q[1] * tx);
+}
+
+PoseHistory::PoseHistory()
+	: m_Count(0)
+{
+	for (int i = 0; i < POSE_HISTORY_SIZE; i++)
+	{
+		m_Slot[i].Sequence.store(0);
+		m_Slot[i].Index = -1;
+	}
+}
+
+void PoseHistory::Publish(const PoseFrame& frame)
+{
+	long long index = m_Count.load(std::memory_order_relaxed);
+	Slot& slot = m_Slot[index % POSE_HISTORY_SIZE];
+
+	unsigned int sequence = slot.Sequence.load(std::memory_order_relaxed);
+	slot.Sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.Index = index;
+	slot.Frame = frame;
+	slot.Sequence.store(sequence + 2, std::memory_order_release);
+
+	m_Count.store(index + 1, std::memory_order_release);
+}
+
+bool PoseHistory::Read(long long index, PoseFrame& frame) const
+{
+	const Slot& slot = m_Slot[index % POSE_HISTORY_SIZE];
+	for (int retry = 0; retry < READ_RETRY; retry++)
+	{
+		unsigned int sequence = slot.Sequence.load(std::memory_order_acquire);
+		if (sequence & 1)
+		{
+			continue;
+		}
+		long long slotIndex = slot.Index;
+		frame = slot.Frame;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.Sequence.load(std::memory_order_relaxed) == sequence)
+		{
+			return (slotIndex == index);
+		}
+	}
+	return false;
+}
+
+bool PoseHistory::Latest(PoseFrame& frame) const
+{
+	long long count = m_Count.load(std::memory_order_acquire);
+	return (count > 0) && Read(count - 1, frame);
+}
+
+bool PoseHistory::FindInterval(double time, PoseFrame& frame0, PoseFrame& frame1) const
+{
+	long long count = m_Count.load(std::memory_order_acquire);
+	if (count == 0)
+	{
+		return false;
+	}
+
+	long long newest = count - 1;
+	if (!Read(newest, frame1))
+	{
+		return false;
+	}
+	if ((time >= frame1.Time) || (count == 1))
+	{
+		// newest two frames
+		if ((count == 1) || !Read(newest - 1, frame0))
+		{
+			frame0 = frame1;
+		}
+		return true;
+	}
+
+	// binary search for frame0.Time <= time < frame1.Time; slots that are
+	// overwritten while searching count as too old
+	long long low = std::max(0LL, count - POSE_HISTORY_SIZE + 1);
+	long long high = newest;
+	PoseFrame frame;
+	while (high - low > 1)
+	{
+		long long middle = (low + high) / 2;
+		if (!Read(middle, frame) || (frame.Time <= time))
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle;
+			frame1 = frame;
+		}
+	}
+	if (!Read(low, frame0))
+	{
+		frame0 = frame1;
+	}
+	return true;
+}
+
+bool PoseHistory::Sample(double time, int device, bool navigated, Pose& pose) const
+{
+	PoseFrame frame0, frame1;
+	if (!FindInterval(time, frame0, frame1))
+	{
+		return false;
+	}
+
+	bool isTracked0 = IsTracked(frame0, device);
+	bool isTracked1 = IsTracked(frame1, device);
+	int space = navigated ? 1 : 0;
+	if (isTracked0 && isTracked1 && (frame1.Time > frame0.Time))
+	{
+		double t = (time - frame0.Time) / (frame1.Time - frame0.Time);
+		t = std::min(std::max(t, 0.0), 1.0);
+		InterpolatePose(frame0.Device[device][space], frame1.Device[device][space], static_cast<float>(t), pose);
+		return true;
+	}
+	else if (isTracked1)
+	{
+		pose = frame1.Device[device][space];
+		return true;
+	}
+	else if (isTracked0)
+	{
+		pose = frame0.Device[device][space];
+		return true;
+	}
+	return false;
+}
+
+bool PoseHistory::Velocity(double time, int device, bool navigated, float linear[3], float angular[3]) const
+{
+	PoseFrame frame0, frame1;
+	if (!FindInterval(time, frame0, frame1) ||
+		!IsTracked(frame0, device) || !IsTracked(frame1, device) || (frame1.Time <= frame0.Time))
+	{
+		return false;
+	}
+
+	int space = navigated ? 1 : 0;
+	const Pose& pose0 = frame0.Device[device][space];
+	const Pose& pose1 = frame1.Device[device][space];
+	float dt = static_cast<float>(frame1.Time - frame0.Time);
+	for (int i = 0; i < 3; i++)
+	{
+		linear[i] = (pose1.Position[i] - pose0.Position[i]) / dt;
+	}
+
+	// dq = q1 * conj(q0) as axis * angle
+	const float *a = pose1.Orientation;
+	float b[4] = { -pose0.Orientation[0], -pose0.Orientation[1], -pose0.Orientation[2], pose0.Orientation[3] };
+	float dq[4] = {
+		a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1],
+		a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0],
+		a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3],
+		a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2] };
+	if (dq[3] < 0.0f)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			dq[i] = -dq[i];
+		}
+	}
+	float sinHalf = sqrtf(dq[0] * dq[0] + dq[1] * dq[1] + dq[2] * dq[2]);
+	float angle = 2.0f * atan2f(sinHalf, dq[3]);
+	float scale = (sinHalf > 1.0e-6f) ? angle / (sinHalf * dt) : 2.0f / dt;
+	for (int i = 0; i < 3; i++)
+	{
+		angular[i] = dq[i] * scale;
+	}
+	return true;
+}
+
+bool PoseHistory::Extrapolate(double time, int device, bool navigated, Pose& pose) const
+{
+	PoseFrame frame;
+	if (!Latest(frame) || (time <= frame.Time) || !IsTracked(frame, device))
+	{
+		return Sample(time, device, navigated, pose);
+	}
+
+	pose = frame.Device[device][navigated ? 1 : 0];
+	float linear[3], angular[3];
+	if (!Velocity(frame.Time, device, navigated, linear, angular))
+	{
+		return true;
+	}
+
+	float dt = static_cast<float>(std::min(time - frame.Time, MAX_EXTRAPOLATION));
+	for (int i = 0; i < 3; i++)
+	{
+		pose.Position[i] += linear[i] * dt;
+	}
+
+	// q = exp(angular * dt / 2) * q
+	float angle = sqrtf(angular[0] * angular[0] + angular[1] * angular[1] + angular[2] * angular[2]) * dt;
+	if (angle > 1.0e-6f)
+	{
+		float s = sinf(0.5f * angle) / (angle / dt);
+		float a[4] = { angular[0] * s, angular[1] * s, angular[2] * s, cosf(0.5f * angle) };
+		const float b[4] = { pose.Orientation[0], pose.Orientation[1], pose.Orientation[2], pose.Orientation[3] };
+		pose.Orientation[0] = a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1];
+		pose.Orientation[1] = a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0];
+		pose.Orientation[2] = a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3];
+		pose.Orientation[3] = a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2];
+	}
+	return true;
+}
+
+int PoseHistory::GetHistory(double fromTime, int device, bool navigated, double *times, Pose *poses, int maxCount) const
+{
+	int numPoses = VisitHistory(fromTime, device, navigated, maxCount, [times, poses](int i, double time, const Pose& pose)
+	{
+		times[i] = time;
+		poses[i] = pose;
+	});
+	std::reverse(times, times + numPoses);
+	std::reverse(poses, poses + numPoses);
+	return numPoses;
+}
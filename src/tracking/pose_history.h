@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// pose_history.h
+//
+//   CLCL: CAVELib Compatible Library
+//
+//     Copyright 2015-2019 Shintaro Kawahara(kawahara@jamstec.go.jp).
+//     All rights reserved.
+//
+//   Please read the file "LICENCE.txt" before you use this software.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+
+typedef enum {
+	POSE_HEAD = 0,
+	POSE_LEFT_HAND,
+	POSE_RIGHT_HAND,
+	POSE_DEVICE_COUNT
+} POSE_DEVICE;
+
+struct Pose
+{
+	float Position[3];    // CAVE (or navigated) coordinate
+	float Orientation[4]; // quaternion (x, y, z, w)
+};
+
+struct PoseFrame
+{
+	double       Time;           // seconds (ovr_GetTimeInSeconds)
+	unsigned int TrackedDevices; // bit (1 << POSE_DEVICE)
+	Pose         Device[POSE_DEVICE_COUNT][2]; // physical, navigated
+};
+
+typedef enum {
+	SENSOR_HEAD = 0,
+	SENSOR_LEFT_EYE,
+	SENSOR_RIGHT_EYE,
+	SENSOR_LEFT_HAND,
+	SENSOR_RIGHT_HAND,
+	SENSOR_COUNT
+} SENSOR;
+
+struct SensorState
+{
+	float Position[3];    // CAVE (or navigated) coordinate
+	float Orientation[4]; // quaternion (x, y, z, w)
+	float Angle[3];       // Euler angles (Y, X, Z) in radians
+	float Front[3];       // unit vectors
+	float Up[3];
+	float Right[3];
+};
+
+// every sensor of one display frame
+struct SensorFrame
+{
+	long long    Frame;
+	double       Time;           // seconds (ovr_GetTimeInSeconds)
+	unsigned int TrackedSensors; // bit (1 << SENSOR)
+	SensorState  Sensor[SENSOR_COUNT][2]; // physical, navigated
+};
+
+const int POSE_HISTORY_SIZE = 1024;
+const double MAX_EXTRAPOLATION = 0.1;
+
+// Ring of timestamped poses with a single writer and lock-free readers.
+// Each slot is guarded by a sequence number (odd while being written), so a
+// reader retries or skips a slot that is overwritten during the copy.
+class PoseHistory
+{
+public:
+	PoseHistory();
+
+	void Publish(const PoseFrame& frame); // one writer at a time
+
+	bool Latest(PoseFrame& frame) const;
+	bool Sample(double time, int device, bool navigated, Pose& pose) const;
+	bool Velocity(double time, int device, bool navigated, float linear[3], float angular[3]) const;
+	// Sample() within the history, extrapolated with the latest velocities
+	// (for at most MAX_EXTRAPOLATION seconds) after it
+	bool Extrapolate(double time, int device, bool navigated, Pose& pose) const;
+	// poses since fromTime, oldest first (at most the latest maxCount)
+	int  GetHistory(double fromTime, int device, bool navigated, double *times, Pose *poses, int maxCount) const;
+	// calls output(i, time, pose) for the same poses, newest first (i = 0),
+	// so that a caller can copy them into its own buffer
+	template <typename Output>
+	int  VisitHistory(double fromTime, int device, bool navigated, int maxCount, Output output) const;
+
+private:
+	struct Slot
+	{
+		std::atomic<unsigned int> Sequence;
+		long long                 Index;
+		PoseFrame                 Frame;
+	};
+
+	Slot                   m_Slot[POSE_HISTORY_SIZE];
+	std::atomic<long long> m_Count; // number of published frames
+
+	bool Read(long long index, PoseFrame& frame) const;
+	bool FindInterval(double time, PoseFrame& frame0, PoseFrame& frame1) const;
+};
+
+template <typename Output>
+int PoseHistory::VisitHistory(double fromTime, int device, bool navigated, int maxCount, Output output) const
+{
+	long long count = m_Count.load(std::memory_order_acquire);
+	long long oldest = (count > POSE_HISTORY_SIZE - 1) ? (count - POSE_HISTORY_SIZE + 1) : 0;
+	int space = navigated ? 1 : 0;
+
+	int numPoses = 0;
+	PoseFrame frame;
+	for (long long index = count - 1; (index >= oldest) && (numPoses < maxCount); index--)
+	{
+		if (!Read(index, frame) || (frame.Time < fromTime))
+		{
+			break;
+		}
+		if ((frame.TrackedDevices & (1u << device)) != 0)
+		{
+			output(numPoses, frame.Time, frame.Device[device][space]);
+			numPoses++;
+		}
+	}
+	return numPoses;
+}
+
+void InterpolatePose(const Pose& pose0, const Pose& pose1, float t, Pose& pose);
+void RotateVector(const float q[4], const float v[3], float out[3]);